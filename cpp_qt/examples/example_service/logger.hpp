@@ -2,6 +2,8 @@
 
 #include <QtCore/QObject>
 
+#include <background/log_writer>
+
 class logger : public QObject
 {
     public :
@@ -12,15 +14,9 @@ class logger : public QObject
     void set_up_logging_to_file ();
     void set_back_to_logging_to_console ();
 
-    protected :
-    void accumulate_messages_until_started ();
-
-    Q_SIGNALS :
-    void log (const QString & message);
-
-    protected Q_SLOTS :
-    void log_ (const QString & message);
-    void log_while_starting (const QString & message);
+    private :
+    // The messages logged until the file is set up wait in the ring of the writer.
+    background::log_writer writer;
 
     private :
     Q_OBJECT
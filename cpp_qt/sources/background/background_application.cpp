@@ -1,65 +1,92 @@
 #include "background_application.hpp"
 
 #include <functional>
+#include <array>
+#include <algorithm>
 #include <vector>
-#include <deque>
-#include <map>
+#include <utility>
 #include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <memory>
+#include <atomic>
 
 #include <QtCore/QPointer>
 #include <QtCore/QAtomicPointer>
+#include <QtCore/QTimer>
+#include <QtCore/QElapsedTimer>
 #include <QtCore/QMetaMethod>
-#include <QtCore/QPluginLoader>
 #include <QtCore/QLoggingCategory>
+#include <QtCore/QCoreApplication>
+#include <QtCore/QEvent>
+#include <QtCore/QThreadPool>
+#include <QtCore/QFutureWatcher>
+#include <QtCore/QPromise>
 
 #include "background_datatypes.hpp"
 #include "background_event_loop_controller.hpp"
 #include "background_event_loop_controller_qt.hpp"
 #include "background_service_platform.hpp"
 #include "background_console_platform.hpp"
+#include "background_descriptors.hpp"
+#include "background_deadline_guard.hpp"
+#include "background_memory_pressure_monitor.hpp"
+#include "background_cpu_budget_monitor.hpp"
+#include "background_upgrade_process.hpp"
+#include "background_lifecycle_trace.hpp"
+#include "background_lifecycle_table.hpp"
+#include "background_metrics.hpp"
+#include "background_system_event_queue.hpp"
+#if not defined background_no_plugins
+#include "background_plugin_registry.hpp"
+#else
+#include "background_built_in_platforms.hpp"
+#endif
 
 static Q_LOGGING_CATEGORY (category, "background.application")
 
 namespace background
 {
 
-enum class starting_sequence
+namespace
 {
-    none,
-    set_up_event_loop_controller,
 
-    set_up_service_platform,
-    start_service_platform,
-    retrieve_service_configuration,
-    start_serving_1,
-    set_service_state_serving,
+// How often the reported progress is passed on to the system, and how long it keeps the system waiting.
+constexpr std::chrono::seconds progress_interval (1);
+constexpr std::chrono::seconds progress_extension (5);
 
-    set_up_console_platform,
-    start_console_platform,
-    start_serving_2,
+// Posted to proceed from the event loop.
+// Qt takes the ownership of a posted event and deletes it once delivered, so it can not be posted again.
+// Instead, the event takes the same preallocated storage every time: there is at most one posted at a time,
+// as there is a single 'application' and it does not post again while queueing.
+class proceed_event : public QEvent
+{
+    public :
+    proceed_event ();
 
-    start_serving_3,
+    public :
+    static Type type ();
 
-    set_state_serving,
-    done
+    static void * operator new (std::size_t size);
+    static void operator delete (void * pointer);
 };
 
-enum class stopping_sequence
-{
-    none,
-    set_up_event_loop_controller,
+alignas (proceed_event) unsigned char proceed_event_storage [sizeof (proceed_event)];
+std::atomic<bool> proceed_event_stored (false);
 
-    set_service_state_stopping,
-    stop_serving,
-    set_service_state_stopped,
-    stop_service_platform,
+} // namespace
 
-    stop_console_platform,
+namespace
+{
 
-    exit_application,
-    set_state_stopped,
-    done
-};
+QString name (starting_sequence value);
+QString name (stopping_sequence value);
+template <class table, class sequence>
+void check_transition (const table & table_, sequence from, sequence to);
+
+} // namespace
 
 enum class proceeding_state
 {
@@ -99,23 +126,66 @@ class application_implementation
     std::optional<application_error> error;
     std::optional<application_error> error_;
     int exit_code;
+    std::vector<inherited_descriptor> inherited_descriptors;
 
     bool with_stop_starting;
     bool with_running_as_non_service;
     bool no_retrieving_service_configuration;
     bool no_running_as_service;
     bool no_running_as_console_application;
+    double watchdog_tolerance;
+    std::chrono::milliseconds start_timeout;
+    std::chrono::milliseconds stop_timeout;
+    int timeout_exit_code;
+    bool with_synchronous_proceeding;
+    QString trace_file;
+    bool with_fast_exit;
+    std::chrono::milliseconds fast_exit_timeout;
+    pressure_threshold memory_pressure_threshold;
+    std::function<bool ()> start_task;
+    std::function<void ()> stop_task;
+    QThreadPool * task_thread_pool;
 
     protected :
     starting_sequence starting;
     stopping_sequence stopping;
+    reloading_sequence reloading;
+    pausing_sequence pausing;
     proceeding_state proceeding;
     control_state control;
     bool regain_control;
     bool processing_recoverable_error;
     bool error_ignored;
     bool exiting_abruptly;
-    std::deque<application_system_event> system_events;
+    system_event_queue system_events;
+    std::vector<std::function<void ()>> exit_flushes;
+    lifecycle_trace trace;
+    starting_sequence traced_starting;
+    stopping_sequence traced_stopping;
+    application_metrics metrics;
+    service_state measured_state;
+    QElapsedTimer measured_state_elapsed;
+    QElapsedTimer stop_requested;
+    QTimer * watchdog;
+    QElapsedTimer watchdog_elapsed;
+    std::chrono::microseconds watchdog_interval;
+    QDeadlineTimer deadline;
+    deadline_guard guard;
+    QTimer * progress;
+    QElapsedTimer progress_elapsed;
+    memory_pressure_monitor * memory_pressure;
+    cpu_budget_monitor * const cpu_budget;
+    upgrade_process * upgrade;
+    // The serving was handed over, the system is not to be told of stopping.
+    bool upgraded;
+    std::optional<qintptr> upgrade_ready;
+    QByteArray upgrade_state;
+    QFuture<bool> start_task_future;
+    QFuture<void> stop_task_future;
+    QFutureWatcher<bool> * start_task_watcher;
+    QFutureWatcher<void> * stop_task_watcher;
+    // Stopping while the start task is running, the stop task runs once it returns.
+    bool stop_task_pending;
 
     event_loop_controller * event_loop;
     service_platform * service_platform;
@@ -124,11 +194,36 @@ class application_implementation
     protected :
     void proceed_from_event_loop ();
     void check_proceeding_and_lose_control ();
+    proceed_result retake_control ();
+    void observe_transitions ();
     void proceed ();
+    void advance (starting_sequence step);
+    void advance (stopping_sequence step);
+    void advance (reloading_sequence step);
+    void advance (pausing_sequence step);
     proceed_result proceed_starting ();
     proceed_result proceed_stopping ();
+    proceed_result proceed_reloading ();
+    proceed_result proceed_pausing ();
+    bool pausable () const;
+
+    // A stopping step that only waits on a platform: what it asks of the platform, and where it goes once done.
+    struct platform_step
+    {
+        void (application_implementation::* request) ();
+        stopping_sequence next;
+    };
+    // Indexed by the step, with no request for the other steps.
+    static const std::array<platform_step, static_cast<std::size_t> (stopping_sequence::done) + 1> stopping_platform_steps;
+
+    proceed_result proceed_stopping_platform (const platform_step & step);
+    void set_service_state_stopping ();
+    void set_service_state_stopped ();
+    void stop_service_platform ();
+    void stop_console_platform ();
+
     proceed_result process_error ();
-    void process_system_event ();
+    proceed_result process_system_event ();
 
     void set_up_event_loop_controller ();
     void shut_down_before_application_exits ();
@@ -151,7 +246,28 @@ class application_implementation
     void process_console_platform_failed_to_start (const application_error & error);
     void process_console_platform_stopped ();
 
-    template <class T> static std::vector<T *> plugins ();
+    void start_watchdog ();
+    void stop_watchdog ();
+    void keep_alive ();
+
+    void start_deadline (std::chrono::milliseconds timeout, const QString & name);
+    void stop_deadline ();
+    void report_progress ();
+    void extend_timeout ();
+
+    [[ noreturn ]] void exit_fast ();
+
+    void start_memory_pressure_monitor ();
+    void stop_memory_pressure_monitor ();
+
+    void set_up_tasks ();
+    void run_start_task ();
+    void process_start_task_finished ();
+    void run_stop_task ();
+    void process_stop_task_finished ();
+
+    void inherit_upgrade ();
+    void process_upgrade_finished (bool ready);
 
     protected :
     static QBasicAtomicPointer<application_implementation> instance;
@@ -186,25 +302,71 @@ application_implementation::application_implementation (application * const appl
     no_retrieving_service_configuration (false),
     no_running_as_service (false),
     no_running_as_console_application (false),
+    watchdog_tolerance (0.5),
+    start_timeout (std::chrono::milliseconds::zero ()),
+    stop_timeout (std::chrono::milliseconds::zero ()),
+    timeout_exit_code (124),
+    with_synchronous_proceeding (false),
+    trace_file (),
+    with_fast_exit (false),
+    fast_exit_timeout (std::chrono::seconds (1)),
+    memory_pressure_threshold (
+        { // c++20 designated initializers
+            /*.some =*/std::chrono::microseconds::zero (),
+            /*.full =*/std::chrono::microseconds::zero (),
+            // The kernel only allows windows in multiples of 2 s to unprivileged processes.
+            /*.window =*/std::chrono::seconds (2)
+        }
+    ),
+    start_task (),
+    stop_task (),
+    task_thread_pool (nullptr),
     starting (starting_sequence::none),
     stopping (stopping_sequence::none),
+    reloading (reloading_sequence::none),
+    pausing (pausing_sequence::none),
     proceeding (proceeding_state::none),
     control (control_state::none),
     regain_control (false),
+    processing_recoverable_error (false),
+    error_ignored (false),
+    exiting_abruptly (false),
+    traced_starting (starting_sequence::none),
+    traced_stopping (stopping_sequence::none),
+    measured_state (service_state::none),
+    watchdog (nullptr),
+    watchdog_interval (std::chrono::microseconds::zero ()),
+    deadline (QDeadlineTimer::Forever),
+    progress (nullptr),
+    memory_pressure (nullptr),
+    cpu_budget (new cpu_budget_monitor (application)),
+    upgrade (nullptr),
+    upgraded (false),
+    upgrade_ready (std::nullopt),
+    start_task_watcher (nullptr),
+    stop_task_watcher (nullptr),
+    stop_task_pending (false),
     event_loop (nullptr),
     service_platform (nullptr),
     console_platform (nullptr),
-    exiting_abruptly (false),
-    processing_recoverable_error (false),
-    error_ignored (false),
     this_ (application)
-{}
+{
+    QObject::connect (cpu_budget, & cpu_budget_monitor::changed, this_, & application::cpu_budget_changed);
+}
 
 application::~application ()
 {
     assert (this_->state.stopped () or this_->state.none ());
 }
 
+bool application::event (QEvent * const event)
+{
+    if (event->type () != proceed_event::type ())
+        return QObject::event (event);
+    this_->proceed ();
+    return true;
+}
+
 void application::run ()
 {
     assert (this_->state.none ());
@@ -221,6 +383,8 @@ void application::shut_down ()
     if (this_->state.target_state == target_service_state::stopped)
         return;
     this_->state.target_state = target_service_state::stopped;
+    if (not this_->stop_requested.isValid ())
+        this_->stop_requested.start ();
     this_->proceed_from_event_loop ();
 }
 
@@ -234,6 +398,7 @@ void application::set_started ()
         or this_->proceeding != proceeding_state::starting
     )
         return;
+    this_->trace.end (QStringLiteral ("start ()"));
     this_->proceeding = proceeding_state::started;
     this_->proceed_from_event_loop ();
 }
@@ -247,6 +412,7 @@ void application::set_failed_to_start ()
         or this_->proceeding != proceeding_state::starting
     )
         return;
+    this_->trace.end (QStringLiteral ("start ()"));
     this_->state.target_state = target_service_state::stopped;
     this_->proceeding = proceeding_state::failed;
     this_->proceed_from_event_loop ();
@@ -259,10 +425,60 @@ void application::set_stopped ()
         or this_->proceeding != proceeding_state::stopping
     )
         return;
+    this_->trace.end (QStringLiteral ("stop ()"));
     this_->proceeding = proceeding_state::stopped;
     this_->proceed_from_event_loop ();
 }
 
+void application::pause ()
+{
+    if (not this_->pausable () or this_->state.target_state == target_service_state::paused)
+        return;
+    this_->state.target_state = target_service_state::paused;
+    this_->proceed_from_event_loop ();
+}
+
+void application::resume ()
+{
+    if (not this_->pausable () or this_->state.target_state == target_service_state::serving)
+        return;
+    this_->state.target_state = target_service_state::serving;
+    this_->proceed_from_event_loop ();
+}
+
+void application::set_paused ()
+{
+    if (this_->pausing != pausing_sequence::pause_serving)
+        return;
+    this_->advance (pausing_sequence::set_state_paused);
+    this_->proceed_from_event_loop ();
+}
+
+void application::set_resumed ()
+{
+    if (this_->pausing != pausing_sequence::resume_serving)
+        return;
+    this_->advance (pausing_sequence::set_state_serving);
+    this_->proceed_from_event_loop ();
+}
+
+void application::set_reloaded ()
+{
+    switch (this_->reloading)
+    {
+        case reloading_sequence::reload :
+        this_->advance (reloading_sequence::reloaded);
+        break;
+
+        case reloading_sequence::reload_again :
+        this_->advance (reloading_sequence::requested);
+        break;
+
+        default : return;
+    }
+    this_->proceed_from_event_loop ();
+}
+
 void application::ignore_error ()
 {
     if (not this_->processing_recoverable_error)
@@ -295,6 +511,72 @@ const std::optional<application_error> & application::error () const
     return this_->error;
 }
 
+const std::vector<inherited_descriptor> & application::inherited_descriptors () const
+{
+    return this_->inherited_descriptors;
+}
+
+std::optional<qintptr> application::take_inherited_descriptor (const QString & name)
+{
+    auto & descriptors (this_->inherited_descriptors);
+    const auto descriptor (
+        std::find_if (
+            descriptors.cbegin (), descriptors.cend (),
+            [& name] (const inherited_descriptor & descriptor) { return descriptor.name == name; }
+        )
+    );
+    if (descriptor == descriptors.cend ())
+        return std::nullopt;
+    const auto result (descriptor->descriptor);
+    descriptors.erase (descriptor);
+    return result;
+}
+
+bool application::store_descriptor (const QString & name, const qintptr descriptor)
+{
+    if (this_->service_platform == nullptr or not this_->running_as_service.value_or (false))
+        return false;
+    return this_->service_platform->store_descriptor (name, descriptor);
+}
+
+bool application::discard_stored_descriptor (const QString & name)
+{
+    if (this_->service_platform == nullptr or not this_->running_as_service.value_or (false))
+        return false;
+    return this_->service_platform->discard_stored_descriptor (name);
+}
+
+bool application::upgrade (
+    const QString & program, const QStringList & arguments,
+    const std::vector<inherited_descriptor> & descriptors, const QByteArray & state
+)
+{
+    if (not this_->state.serving () or this_->state.target_state == target_service_state::stopped)
+        return false;
+    if (this_->upgrade == nullptr)
+    {
+        this_->upgrade = new upgrade_process (this);
+        QObject::connect (
+            this_->upgrade, & upgrade_process::finished,
+            this, std::bind (& application_implementation::process_upgrade_finished, this_.data (), std::placeholders::_1)
+        );
+    }
+    if (not this_->upgrade->start (program, arguments, descriptors, state))
+    {
+        qCWarning (category).noquote () << text::with_last_error (
+            QStringLiteral ("Failed to upgrade to '%1'").arg (program)
+        );
+        return false;
+    }
+    qCInfo (category, "Upgrading to: '%s', process: '%lld'.", qUtf8Printable (program), this_->upgrade->process_id ());
+    return true;
+}
+
+QByteArray application::take_upgrade_state ()
+{
+    return std::exchange (this_->upgrade_state, QByteArray ());
+}
+
 int application::exit_code () const
 {
     return this_->exit_code;
@@ -305,6 +587,56 @@ void application::set_exit_code (const int exit_code)
     this_->exit_code = exit_code;
 }
 
+double application::cpu_budget () const
+{
+    return this_->cpu_budget->budget ();
+}
+
+int application::ideal_thread_count () const
+{
+    return std::max (1, static_cast<int> (std::ceil (this_->cpu_budget->budget ())));
+}
+
+void application::add_exit_flush (std::function<void ()> flush)
+{
+    this_->exit_flushes.push_back (std::move (flush));
+}
+
+const application_metrics & application::metrics () const
+{
+    return this_->metrics;
+}
+
+QByteArray application::trace () const
+{
+    return this_->trace.to_json ();
+}
+
+QFuture<bool> application::start_task_future () const
+{
+    return this_->start_task_future;
+}
+
+QFuture<void> application::stop_task_future () const
+{
+    return this_->stop_task_future;
+}
+
+QString application::lifecycle_graph ()
+{
+    return background::lifecycle_graph ();
+}
+
+QDeadlineTimer application::deadline () const
+{
+    return this_->deadline;
+}
+
+void application::report_progress ()
+{
+    this_->report_progress ();
+}
+
 bool application::with_stop_starting () const
 {
     return this_->with_stop_starting;
@@ -370,33 +702,233 @@ application & application::set_no_running_as_console_application ()
     return * this;
 }
 
+double application::watchdog_tolerance () const
+{
+    return this_->watchdog_tolerance;
+}
+
+application & application::set_watchdog_tolerance (const double fraction)
+{
+    assert (this_->state.none ());
+    if (this_->state.none ())
+        this_->watchdog_tolerance = fraction;
+    return * this;
+}
+
+std::chrono::milliseconds application::start_timeout () const
+{
+    return this_->start_timeout;
+}
+
+application & application::set_start_timeout (const std::chrono::milliseconds timeout)
+{
+    assert (this_->state.none ());
+    if (this_->state.none ())
+        this_->start_timeout = timeout;
+    return * this;
+}
+
+std::chrono::milliseconds application::stop_timeout () const
+{
+    return this_->stop_timeout;
+}
+
+application & application::set_stop_timeout (const std::chrono::milliseconds timeout)
+{
+    assert (this_->state.none ());
+    if (this_->state.none ())
+        this_->stop_timeout = timeout;
+    return * this;
+}
+
+int application::timeout_exit_code () const
+{
+    return this_->timeout_exit_code;
+}
+
+application & application::set_timeout_exit_code (const int exit_code)
+{
+    assert (this_->state.none ());
+    if (this_->state.none ())
+        this_->timeout_exit_code = exit_code;
+    return * this;
+}
+
+bool application::with_synchronous_proceeding () const
+{
+    return this_->with_synchronous_proceeding;
+}
+
+application & application::set_with_synchronous_proceeding ()
+{
+    assert (this_->state.none ());
+    if (this_->state.none ())
+        this_->with_synchronous_proceeding = true;
+    return * this;
+}
+
+const QString & application::trace_file () const
+{
+    return this_->trace_file;
+}
+
+application & application::set_trace_file (const QString & path)
+{
+    assert (this_->state.none ());
+    if (this_->state.none ())
+        this_->trace_file = path;
+    return * this;
+}
+
+bool application::with_fast_exit () const
+{
+    return this_->with_fast_exit;
+}
+
+application & application::set_with_fast_exit ()
+{
+    assert (this_->state.none ());
+    if (this_->state.none ())
+        this_->with_fast_exit = true;
+    return * this;
+}
+
+std::chrono::milliseconds application::fast_exit_timeout () const
+{
+    return this_->fast_exit_timeout;
+}
+
+application & application::set_fast_exit_timeout (const std::chrono::milliseconds timeout)
+{
+    assert (this_->state.none ());
+    if (this_->state.none ())
+        this_->fast_exit_timeout = timeout;
+    return * this;
+}
+
+const pressure_threshold & application::memory_pressure_threshold () const
+{
+    return this_->memory_pressure_threshold;
+}
+
+application & application::set_memory_pressure_threshold (const pressure_threshold & threshold)
+{
+    assert (this_->state.none ());
+    if (this_->state.none ())
+        this_->memory_pressure_threshold = threshold;
+    return * this;
+}
+
+application & application::set_start_task (std::function<bool ()> task)
+{
+    assert (this_->state.none ());
+    if (this_->state.none ())
+    {
+        this_->start_task = std::move (task);
+        this_->set_up_tasks ();
+    }
+    return * this;
+}
+
+application & application::set_stop_task (std::function<void ()> task)
+{
+    assert (this_->state.none ());
+    if (this_->state.none ())
+    {
+        this_->stop_task = std::move (task);
+        this_->set_up_tasks ();
+    }
+    return * this;
+}
+
+QThreadPool * application::task_thread_pool () const
+{
+    if (this_->task_thread_pool == nullptr)
+        return QThreadPool::globalInstance ();
+    return this_->task_thread_pool;
+}
+
+application & application::set_task_thread_pool (QThreadPool * const pool)
+{
+    assert (this_->state.none ());
+    if (this_->state.none ())
+        this_->task_thread_pool = pool;
+    return * this;
+}
+
 void application_implementation::proceed_from_event_loop ()
 {
     switch (control)
     {
         case control_state::none : break;
-        case control_state::queueing : return;
+        case control_state::queueing :
+        metrics.proceed_coalesced.fetch_add (1, std::memory_order_relaxed);
+        return;
         case control_state::processing :
+        metrics.proceed_coalesced.fetch_add (1, std::memory_order_relaxed);
         regain_control = true;
         return;
     }
+    metrics.proceed_posted.fetch_add (1, std::memory_order_relaxed);
     control = control_state::queueing;
-    QMetaObject::invokeMethod (
-        this_,
-        std::bind (& application_implementation::proceed, this),
-        Qt::QueuedConnection
-    );
+    QCoreApplication::postEvent (this_, new proceed_event);
 }
 
 void application_implementation::check_proceeding_and_lose_control ()
 {
+    observe_transitions ();
     control = control_state::none;
     if (not regain_control)
         return;
     regain_control = false;
+    metrics.control_regained.fetch_add (1, std::memory_order_relaxed);
     proceed_from_event_loop ();
 }
 
+// Control is lost emitting a signal, and the handler proceeding asks to proceed from the event loop.
+// Where the handler is done once it returns, such as with 'set_started ()' called right away,
+// proceeding may as well go on right here instead of waiting behind whatever else is queued.
+// Only while the posted event is still pending: the handler may have run the event loop, and it may have been delivered.
+// Either way, this is not reentered.
+proceed_result application_implementation::retake_control ()
+{
+    if (not with_synchronous_proceeding or control != control_state::queueing)
+        return proceed_result::lost_control;
+    QCoreApplication::removePostedEvents (this_, proceed_event::type ());
+    control = control_state::processing;
+    metrics.control_retaken.fetch_add (1, std::memory_order_relaxed);
+    return proceed_result::continue_;
+}
+
+// A step spans from entering the sequence state until leaving it, and so does a state.
+// Checked whenever control is about to be lost, so that the time in the handlers is accounted to the step.
+void application_implementation::observe_transitions ()
+{
+    if (measured_state != state.state)
+    {
+        if (measured_state_elapsed.isValid ())
+            metrics.state_durations [static_cast<std::size_t> (measured_state)].record (
+                std::chrono::microseconds (measured_state_elapsed.nsecsElapsed () / 1000)
+            );
+        measured_state = state.state;
+        measured_state_elapsed.start ();
+    }
+    if (traced_starting != starting)
+    {
+        trace.end (name (traced_starting));
+        if (starting != starting_sequence::none and starting != starting_sequence::done)
+            trace.begin (lifecycle_trace::sequence, name (starting));
+        traced_starting = starting;
+    }
+    if (traced_stopping != stopping)
+    {
+        trace.end (name (traced_stopping));
+        if (stopping != stopping_sequence::none and stopping != stopping_sequence::done)
+            trace.begin (lifecycle_trace::sequence, name (stopping));
+        traced_stopping = stopping;
+    }
+}
+
 // A higher level routine description.
 // This is a critical section:
 // even where the user regains execution control, it won't enter more than once.
@@ -407,11 +939,18 @@ void application_implementation::proceed ()
     Q_FOREVER
     {
         regain_control = false;
+        metrics.proceed_iterations.fetch_add (1, std::memory_order_relaxed);
+        observe_transitions ();
 
         if (not system_events.empty () and stopping < stopping_sequence::exit_application)
         {
-            process_system_event ();
-            continue;
+            switch (process_system_event ())
+            {
+                case proceed_result::continue_ : continue;
+                case proceed_result::lost_control : return;
+                case proceed_result::destroyed : return;
+                default : Q_UNREACHABLE (); return;
+            }
         }
 
         if (error_.has_value ())
@@ -427,7 +966,7 @@ void application_implementation::proceed ()
         switch (state.target_state)
         {
             case target_service_state::serving :
-            switch (proceed_starting ())
+            switch (starting != starting_sequence::done ? proceed_starting () : proceed_pausing ())
             {
                 case proceed_result::continue_ : continue;
                 case proceed_result::nothing_to_do : break;
@@ -448,10 +987,32 @@ void application_implementation::proceed ()
             }
             break;
 
-            case target_service_state::none : break;
-        }
+            // Reloading is done with before pausing.
+            case target_service_state::paused :
+            switch (reloading != reloading_sequence::none ? proceed_reloading () : proceed_pausing ())
+            {
+                case proceed_result::continue_ : continue;
+                case proceed_result::nothing_to_do : break;
+                case proceed_result::lost_control : return;
+                case proceed_result::destroyed : return;
+                default : Q_UNREACHABLE (); return;
+            }
+            break;
 
-        control = control_state::none;
+            case target_service_state::none :
+            switch (proceed_reloading ())
+            {
+                case proceed_result::continue_ : continue;
+                case proceed_result::nothing_to_do : break;
+                case proceed_result::lost_control : return;
+                case proceed_result::destroyed : return;
+                default : Q_UNREACHABLE (); return;
+            }
+            break;
+        }
+
+        observe_transitions ();
+        control = control_state::none;
         regain_control = false;
         break;
     }
@@ -461,6 +1022,30 @@ void application_implementation::proceed ()
 // it is read from a single place and is perceived consequent.
 // The state controls what has already been done and
 // what to be done to achieve the target state in different scenarios.
+void application_implementation::advance (const starting_sequence step)
+{
+    check_transition (starting_table, starting, step);
+    starting = step;
+}
+
+void application_implementation::advance (const stopping_sequence step)
+{
+    check_transition (stopping_table, stopping, step);
+    stopping = step;
+}
+
+void application_implementation::advance (const reloading_sequence step)
+{
+    check_transition (reloading_table, reloading, step);
+    reloading = step;
+}
+
+void application_implementation::advance (const pausing_sequence step)
+{
+    check_transition (pausing_table, pausing, step);
+    pausing = step;
+}
+
 proceed_result application_implementation::proceed_starting ()
 {
     switch (starting)
@@ -478,7 +1063,7 @@ proceed_result application_implementation::proceed_starting ()
             assert (false);
             state.state = service_state::stopped;
             state.target_state = target_service_state::none;
-            stopping = stopping_sequence::done;
+            advance (stopping_sequence::done);
             return proceed_result::nothing_to_do;
         }
         // Logging is losing control.
@@ -488,18 +1073,25 @@ proceed_result application_implementation::proceed_starting ()
         // The paranoid approach of checking that this instance still exists after
         // every call to another module does not scale.
         qCInfo (category, "Starting...");
-        starting = starting_sequence::set_up_event_loop_controller;
+        start_deadline (start_timeout, QStringLiteral ("start"));
+        advance (starting_sequence::set_up_event_loop_controller);
         [[ fallthrough ]];
 
         case starting_sequence::set_up_event_loop_controller :
         // 'QObject::connect' can also lose control via 'QObject::connectNotify'.
         set_up_event_loop_controller ();
+        cpu_budget->start ();
+        // Whether a service or not, the sockets might have been passed along.
+        inherited_descriptors = inherit_descriptors ();
+        inherit_upgrade ();
+        if (not inherited_descriptors.empty ())
+            qCInfo (category, "Inherited descriptors: '%d'.", static_cast<int> (inherited_descriptors.size ()));
         if (not no_running_as_service)
-            starting = starting_sequence::set_up_service_platform;
+            advance (starting_sequence::set_up_service_platform);
         else if (not no_running_as_console_application)
-            starting = starting_sequence::set_up_console_platform;
+            advance (starting_sequence::set_up_console_platform);
         else
-            starting = starting_sequence::start_serving_3;
+            advance (starting_sequence::start_serving_3);
         return proceed_result::continue_;
 
         case starting_sequence::set_up_service_platform :
@@ -511,12 +1103,12 @@ proceed_result application_implementation::proceed_starting ()
 
             case proceeding_state::started :
             proceeding = proceeding_state::none;
-            starting = starting_sequence::start_service_platform;
+            advance (starting_sequence::start_service_platform);
             break;
 
             case proceeding_state::failed :
             proceeding = proceeding_state::none;
-            starting = starting_sequence::set_up_console_platform;
+            advance (starting_sequence::set_up_console_platform);
             return proceed_result::continue_;
 
             default : Q_UNREACHABLE (); return proceed_result::nothing_to_do;
@@ -535,12 +1127,12 @@ proceed_result application_implementation::proceed_starting ()
 
             case proceeding_state::started :
             proceeding = proceeding_state::none;
-            starting = starting_sequence::retrieve_service_configuration;
+            advance (starting_sequence::retrieve_service_configuration);
             break;
 
             case proceeding_state::failed :
             proceeding = proceeding_state::none;
-            starting = starting_sequence::set_up_console_platform;
+            advance (starting_sequence::set_up_console_platform);
             return proceed_result::continue_;
 
             default : Q_UNREACHABLE (); return proceed_result::nothing_to_do;
@@ -553,7 +1145,7 @@ proceed_result application_implementation::proceed_starting ()
             case proceeding_state::none :
             if (no_retrieving_service_configuration)
             {
-                starting = starting_sequence::start_serving_1;
+                advance (starting_sequence::start_serving_1);
                 break;
             }
             proceeding = proceeding_state::starting;
@@ -564,12 +1156,12 @@ proceed_result application_implementation::proceed_starting ()
 
             case proceeding_state::started :
             proceeding = proceeding_state::none;
-            starting = starting_sequence::start_serving_1;
+            advance (starting_sequence::start_serving_1);
             break;
 
             case proceeding_state::failed :
             proceeding = proceeding_state::none;
-            starting = starting_sequence::start_serving_1;
+            advance (starting_sequence::start_serving_1);
             break;
 
             default : Q_UNREACHABLE (); return proceed_result::nothing_to_do;
@@ -593,18 +1185,19 @@ proceed_result application_implementation::proceed_starting ()
             // The control will be returned through the public methods.
             {
                 check_proceeding_and_lose_control ();
+                trace.begin (lifecycle_trace::handler, QStringLiteral ("start ()"));
                 const QPointer<const application> this_exists (this_);
                 Q_EMIT this_->start ();
                 if (this_exists.isNull ())
                     return proceed_result::destroyed;
             }
-            return proceed_result::lost_control;
+            return retake_control ();
 
             case proceeding_state::starting : return proceed_result::nothing_to_do;
 
             case proceeding_state::started :
             proceeding = proceeding_state::none;
-            starting = starting_sequence::set_service_state_serving;
+            advance (starting_sequence::set_service_state_serving);
             break;
 
             default : Q_UNREACHABLE (); return proceed_result::nothing_to_do;
@@ -626,7 +1219,8 @@ proceed_result application_implementation::proceed_starting ()
 
             case proceeding_state::started :
             proceeding = proceeding_state::none;
-            starting = starting_sequence::set_state_serving;
+            start_watchdog ();
+            advance (starting_sequence::set_state_serving);
             return proceed_result::continue_;
 
             default : Q_UNREACHABLE (); return proceed_result::nothing_to_do;
@@ -647,7 +1241,7 @@ proceed_result application_implementation::proceed_starting ()
 
             case proceeding_state::started :
             proceeding = proceeding_state::none;
-            starting = starting_sequence::start_console_platform;
+            advance (starting_sequence::start_console_platform);
             break;
 
             default : Q_UNREACHABLE (); return proceed_result::nothing_to_do;
@@ -666,7 +1260,7 @@ proceed_result application_implementation::proceed_starting ()
 
             case proceeding_state::started :
             proceeding = proceeding_state::none;
-            starting = starting_sequence::start_serving_2;
+            advance (starting_sequence::start_serving_2);
             break;
 
             default : Q_UNREACHABLE (); return proceed_result::nothing_to_do;
@@ -686,18 +1280,19 @@ proceed_result application_implementation::proceed_starting ()
                 return proceed_result::continue_;
             {
                 check_proceeding_and_lose_control ();
+                trace.begin (lifecycle_trace::handler, QStringLiteral ("start ()"));
                 const QPointer<const application> this_exists (this_);
                 Q_EMIT this_->start ();
                 if (this_exists.isNull ())
                     return proceed_result::destroyed;
             }
-            return proceed_result::lost_control;
+            return retake_control ();
 
             case proceeding_state::starting : return proceed_result::nothing_to_do;
 
             case proceeding_state::started :
             proceeding = proceeding_state::none;
-            starting = starting_sequence::set_state_serving;
+            advance (starting_sequence::set_state_serving);
             return proceed_result::continue_;
 
             default : Q_UNREACHABLE (); return proceed_result::nothing_to_do;
@@ -716,18 +1311,19 @@ proceed_result application_implementation::proceed_starting ()
                 return proceed_result::continue_;
             {
                 check_proceeding_and_lose_control ();
+                trace.begin (lifecycle_trace::handler, QStringLiteral ("start ()"));
                 const QPointer<const application> this_exists (this_);
                 Q_EMIT this_->start ();
                 if (this_exists.isNull ())
                     return proceed_result::destroyed;
             }
-            return proceed_result::lost_control;
+            return retake_control ();
 
             case proceeding_state::starting : return proceed_result::nothing_to_do;
 
             case proceeding_state::started :
             proceeding = proceeding_state::none;
-            starting = starting_sequence::set_state_serving;
+            advance (starting_sequence::set_state_serving);
             return proceed_result::continue_;
 
             default : Q_UNREACHABLE (); return proceed_result::nothing_to_do;
@@ -737,7 +1333,15 @@ proceed_result application_implementation::proceed_starting ()
         state.state = service_state::serving;
         state.target_state = target_service_state::none;
         qCInfo (category, "Serving...");
-        starting = starting_sequence::done;
+        stop_deadline ();
+        start_memory_pressure_monitor ();
+        // The previous instance stops only now.
+        if (upgrade_ready.has_value ())
+        {
+            upgrade_process::report_ready (upgrade_ready.value ());
+            upgrade_ready.reset ();
+        }
+        advance (starting_sequence::done);
         if (not this_->isSignalConnected (QMetaMethod::fromSignal (& application::state_changed)))
             return proceed_result::continue_;
         {
@@ -747,7 +1351,7 @@ proceed_result application_implementation::proceed_starting ()
             if (this_exists.isNull ())
                 return proceed_result::destroyed;
         }
-        return proceed_result::lost_control;
+        return retake_control ();
 
         case starting_sequence::done :
         default : Q_UNREACHABLE (); return proceed_result::nothing_to_do;
@@ -756,14 +1360,27 @@ proceed_result application_implementation::proceed_starting ()
 
 proceed_result application_implementation::proceed_stopping ()
 {
+    const auto & platform_step (stopping_platform_steps [stopping_table.index (stopping)]);
+    if (platform_step.request != nullptr)
+        return proceed_stopping_platform (platform_step);
+
     switch (stopping)
     {
         case stopping_sequence::none :
+        stop_watchdog ();
+        stop_memory_pressure_monitor ();
+        // Abandoned, rather than a transition of their own.
+        reloading = reloading_sequence::none;
+        pausing = pausing_sequence::none;
         switch (starting)
         {
             case starting_sequence::done :
             state.state = service_state::stopping;
-            stopping = stopping_sequence::stop_serving;
+            // Upgraded, the new instance is the one serving: the service manager is not told of stopping.
+            if (service_platform != nullptr and not upgraded)
+                advance (stopping_sequence::set_service_state_stopping);
+            else
+                advance (stopping_sequence::stop_serving);
             break;
 
             case starting_sequence::start_serving_1 :
@@ -781,8 +1398,9 @@ proceed_result application_implementation::proceed_stopping ()
                 case proceeding_state::failed :
                 state.state = service_state::stopping;
                 qCInfo (category, "Failed to start serving. Stopping...");
+                start_deadline (stop_timeout, QStringLiteral ("stop"));
                 proceeding = proceeding_state::none;
-                stopping = stopping_sequence::stop_serving;
+                advance (stopping_sequence::stop_serving);
                 return proceed_result::continue_;
 
                 default : Q_UNREACHABLE (); return proceed_result::nothing_to_do;
@@ -790,9 +1408,9 @@ proceed_result application_implementation::proceed_stopping ()
             state.state = service_state::stopping;
             proceeding = proceeding_state::none;
             if (service_platform != nullptr)
-                stopping = stopping_sequence::set_service_state_stopping;
+                advance (stopping_sequence::set_service_state_stopping);
             else
-                stopping = stopping_sequence::stop_serving;
+                advance (stopping_sequence::stop_serving);
             break;
 
             case starting_sequence::set_service_state_serving :
@@ -807,7 +1425,7 @@ proceed_result application_implementation::proceed_stopping ()
             }
             state.state = service_state::stopping;
             proceeding = proceeding_state::none;
-            stopping = stopping_sequence::set_service_state_stopping;
+            advance (stopping_sequence::set_service_state_stopping);
             break;
 
             case starting_sequence::retrieve_service_configuration :
@@ -822,7 +1440,7 @@ proceed_result application_implementation::proceed_stopping ()
             }
             state.state = service_state::stopped;
             proceeding = proceeding_state::none;
-            stopping = stopping_sequence::set_service_state_stopped;
+            advance (stopping_sequence::set_service_state_stopped);
             break;
 
             case starting_sequence::start_service_platform :
@@ -833,13 +1451,13 @@ proceed_result application_implementation::proceed_stopping ()
                 case proceeding_state::started :
                 state.state = service_state::stopped;
                 proceeding = proceeding_state::none;
-                stopping = stopping_sequence::set_service_state_stopped;
+                advance (stopping_sequence::set_service_state_stopped);
                 break;
 
                 case proceeding_state::failed :
                 state.state = service_state::stopped;
                 proceeding = proceeding_state::none;
-                stopping = stopping_sequence::exit_application;
+                advance (stopping_sequence::exit_application);
                 break;
 
                 default : Q_UNREACHABLE (); return proceed_result::nothing_to_do;
@@ -854,13 +1472,13 @@ proceed_result application_implementation::proceed_stopping ()
                 case proceeding_state::started :
                 state.state = service_state::stopped;
                 proceeding = proceeding_state::none;
-                stopping = stopping_sequence::stop_console_platform;
+                advance (stopping_sequence::stop_console_platform);
                 break;
 
                 case proceeding_state::failed :
                 state.state = service_state::stopped;
                 proceeding = proceeding_state::none;
-                stopping = stopping_sequence::exit_application;
+                advance (stopping_sequence::exit_application);
                 break;
 
                 default : Q_UNREACHABLE (); return proceed_result::nothing_to_do;
@@ -872,132 +1490,74 @@ proceed_result application_implementation::proceed_stopping ()
             //case starting_sequence::set_up_event_loop_controller :
             state.state = service_state::stopped;
             proceeding = proceeding_state::none;
-            stopping = stopping_sequence::exit_application;
+            advance (stopping_sequence::exit_application);
             break;
 
             case starting_sequence::none :
             state.state = service_state::stopped;
-            stopping = stopping_sequence::set_up_event_loop_controller;
+            advance (stopping_sequence::set_up_event_loop_controller);
             break;
 
             default : Q_UNREACHABLE (); return proceed_result::nothing_to_do;
         }
         qCInfo (category, "Stopping...");
+        start_deadline (stop_timeout, QStringLiteral ("stop"));
         return proceed_result::continue_;
 
         case stopping_sequence::set_up_event_loop_controller :
         set_up_event_loop_controller ();
-        stopping = stopping_sequence::exit_application;
+        advance (stopping_sequence::exit_application);
         return proceed_result::continue_;
 
-        case stopping_sequence::set_service_state_stopping :
-        switch (proceeding)
-        {
-            case proceeding_state::none :
-            proceeding = proceeding_state::stopping;
-            // On the contrary, the failure of setting the service state to stopping or stopped is of no interest.
-            // So the error is not in the model, and the platform implementation should just log it.
-            service_platform->set_state_stopping ();
-            return proceed_result::continue_;
-
-            case proceeding_state::stopping : return proceed_result::nothing_to_do;
-
-            case proceeding_state::stopped :
-            proceeding = proceeding_state::none;
-            stopping = stopping_sequence::stop_serving;
-            return proceed_result::continue_;
-
-            default : Q_UNREACHABLE (); return proceed_result::nothing_to_do;
-        }
-
         case stopping_sequence::stop_serving :
         switch (proceeding)
         {
             case proceeding_state::none :
             state.state = service_state::stopping;
             qCInfo (category, "Stop serving.");
+            if (stop_requested.isValid ())
+                metrics.stop_latency.record (std::chrono::microseconds (stop_requested.nsecsElapsed () / 1000));
             proceeding = proceeding_state::stopping;
             if (not this_->isSignalConnected (QMetaMethod::fromSignal (& application::stop)))
                 return proceed_result::continue_;
             {
                 check_proceeding_and_lose_control ();
+                trace.begin (lifecycle_trace::handler, QStringLiteral ("stop ()"));
                 const QPointer<const application> this_exists (this_);
                 Q_EMIT this_->stop ();
                 if (this_exists.isNull ())
                     return proceed_result::destroyed;
             }
-            return proceed_result::lost_control;
+            return retake_control ();
 
             case proceeding_state::stopping : return proceed_result::nothing_to_do;
 
             case proceeding_state::stopped :
             proceeding = proceeding_state::none;
-            if (service_platform != nullptr)
-                stopping = stopping_sequence::set_service_state_stopped;
+            if (service_platform != nullptr and upgraded)
+                advance (stopping_sequence::stop_service_platform);
+            else if (service_platform != nullptr)
+                advance (stopping_sequence::set_service_state_stopped);
             else if (console_platform != nullptr)
-                stopping = stopping_sequence::stop_console_platform;
+                advance (stopping_sequence::stop_console_platform);
             else
-                stopping = stopping_sequence::exit_application;
+                advance (stopping_sequence::exit_application);
             return proceed_result::continue_;
 
             default : Q_UNREACHABLE (); return proceed_result::nothing_to_do;
         }
 
-        case stopping_sequence::set_service_state_stopped :
-        switch (proceeding)
-        {
-            case proceeding_state::none :
-            proceeding = proceeding_state::stopping;
-            service_platform->set_state_stopped (exit_code);
-            return proceed_result::continue_;
-
-            case proceeding_state::stopping : return proceed_result::nothing_to_do;
-
-            case proceeding_state::stopped :
-            proceeding = proceeding_state::none;
-            stopping = stopping_sequence::stop_service_platform;
-            return proceed_result::continue_;
-
-            default : Q_UNREACHABLE (); return proceed_result::nothing_to_do;
-        }
-
-        case stopping_sequence::stop_service_platform :
-        switch (proceeding)
-        {
-            case proceeding_state::none :
-            proceeding = proceeding_state::stopping;
-            service_platform->stop ();
-            return proceed_result::continue_;
-
-            case proceeding_state::stopping : return proceed_result::nothing_to_do;
-
-            case proceeding_state::stopped :
-            proceeding = proceeding_state::none;
-            stopping = stopping_sequence::exit_application;
-            return proceed_result::continue_;
-
-            default : Q_UNREACHABLE (); return proceed_result::nothing_to_do;
-        }
-
-        case stopping_sequence::stop_console_platform :
-        switch (proceeding)
+        case stopping_sequence::exit_application :
+        stop_deadline ();
+        cpu_budget->stop ();
+        if (not trace_file.isEmpty ())
         {
-            case proceeding_state::none :
-            proceeding = proceeding_state::stopping;
-            console_platform->stop ();
-            return proceed_result::continue_;
-
-            case proceeding_state::stopping : return proceed_result::nothing_to_do;
-
-            case proceeding_state::stopped :
-            proceeding = proceeding_state::none;
-            stopping = stopping_sequence::exit_application;
-            return proceed_result::continue_;
-
-            default : Q_UNREACHABLE (); return proceed_result::nothing_to_do;
+            observe_transitions ();
+            if (not trace.write (trace_file))
+                qCWarning (category).noquote () << text::with_last_error (
+                    QStringLiteral ("Failed to write the trace to '%1'").arg (trace_file)
+                );
         }
-
-        case stopping_sequence::exit_application :
         // The exit code can be set anyway.
         // https://code.woboq.org/qt6/qtbase/src/corelib/kernel/qeventloop.cpp.html#_ZN10QEventLoop4exitEi
         if (not exiting_abruptly)
@@ -1008,24 +1568,25 @@ proceed_result application_implementation::proceed_stopping ()
                 qCInfo (category, "Exit with the result: '%d'.", exit_code);
             event_loop->exit (exit_code);
         }
-        stopping = stopping_sequence::set_state_stopped;
+        advance (stopping_sequence::set_state_stopped);
         [[ fallthrough ]];
 
         case stopping_sequence::set_state_stopped :
         state.state = service_state::stopped;
         state.target_state = target_service_state::none;
         qCInfo (category, "Stopped.");
-        stopping = stopping_sequence::done;
+        advance (stopping_sequence::done);
         system_events.clear ();
         instance.testAndSetRelaxed (this, nullptr);
-        if (not this_->isSignalConnected (QMetaMethod::fromSignal (& application::state_changed)))
-            return proceed_result::nothing_to_do;
+        if (this_->isSignalConnected (QMetaMethod::fromSignal (& application::state_changed)))
         {
             const QPointer<const application> this_exists (this_);
             Q_EMIT this_->state_changed ();
             if (this_exists.isNull ())
                 return proceed_result::destroyed;
         }
+        if (with_fast_exit)
+            exit_fast ();
         return proceed_result::nothing_to_do;
 
         case stopping_sequence::done :
@@ -1033,6 +1594,201 @@ proceed_result application_implementation::proceed_stopping ()
     }
 }
 
+const std::array<
+    application_implementation::platform_step,
+    static_cast<std::size_t> (stopping_sequence::done) + 1
+> application_implementation::stopping_platform_steps
+{{
+    /*none*/{ nullptr, stopping_sequence::none },
+    /*set_up_event_loop_controller*/{ nullptr, stopping_sequence::none },
+    /*set_service_state_stopping*/{ & application_implementation::set_service_state_stopping, stopping_sequence::stop_serving },
+    /*stop_serving*/{ nullptr, stopping_sequence::none },
+    /*set_service_state_stopped*/{ & application_implementation::set_service_state_stopped, stopping_sequence::stop_service_platform },
+    /*stop_service_platform*/{ & application_implementation::stop_service_platform, stopping_sequence::exit_application },
+    /*stop_console_platform*/{ & application_implementation::stop_console_platform, stopping_sequence::exit_application },
+    /*exit_application*/{ nullptr, stopping_sequence::none },
+    /*set_state_stopped*/{ nullptr, stopping_sequence::none },
+    /*done*/{ nullptr, stopping_sequence::none }
+}};
+
+proceed_result application_implementation::proceed_stopping_platform (const platform_step & step)
+{
+    switch (proceeding)
+    {
+        case proceeding_state::none :
+        proceeding = proceeding_state::stopping;
+        (this->* step.request) ();
+        return proceed_result::continue_;
+
+        case proceeding_state::stopping : return proceed_result::nothing_to_do;
+
+        case proceeding_state::stopped :
+        proceeding = proceeding_state::none;
+        advance (step.next);
+        return proceed_result::continue_;
+
+        default : Q_UNREACHABLE (); return proceed_result::nothing_to_do;
+    }
+}
+
+// On the contrary, the failure of setting the service state to stopping or stopped is of no interest.
+// So the error is not in the model, and the platform implementation should just log it.
+void application_implementation::set_service_state_stopping ()
+{
+    service_platform->set_state_stopping ();
+}
+
+void application_implementation::set_service_state_stopped ()
+{
+    service_platform->set_state_stopped (exit_code);
+}
+
+void application_implementation::stop_service_platform ()
+{
+    service_platform->stop ();
+}
+
+void application_implementation::stop_console_platform ()
+{
+    console_platform->stop ();
+}
+
+proceed_result application_implementation::proceed_reloading ()
+{
+    switch (reloading)
+    {
+        case reloading_sequence::none : return proceed_result::nothing_to_do;
+
+        case reloading_sequence::requested :
+        advance (reloading_sequence::reload);
+        qCInfo (category, "Reloading...");
+        if (service_platform != nullptr)
+            service_platform->set_state_reloading ();
+        if (not this_->isSignalConnected (QMetaMethod::fromSignal (& application::reload)))
+        {
+            advance (reloading_sequence::reloaded);
+            return proceed_result::continue_;
+        }
+        {
+            check_proceeding_and_lose_control ();
+            const QPointer<const application> this_exists (this_);
+            Q_EMIT this_->reload ();
+            if (this_exists.isNull ())
+                return proceed_result::destroyed;
+        }
+        return retake_control ();
+
+        case reloading_sequence::reload :
+        case reloading_sequence::reload_again : return proceed_result::nothing_to_do;
+
+        case reloading_sequence::reloaded :
+        advance (reloading_sequence::none);
+        if (service_platform != nullptr)
+            service_platform->set_state_reloaded ();
+        qCInfo (category, "Serving...");
+        return proceed_result::continue_;
+
+        default : Q_UNREACHABLE (); return proceed_result::nothing_to_do;
+    }
+}
+
+proceed_result application_implementation::proceed_pausing ()
+{
+    switch (pausing)
+    {
+        case pausing_sequence::none :
+        if (state.state == service_state::serving and state.target_state == target_service_state::paused)
+        {
+            state.state = service_state::pausing;
+            qCInfo (category, "Pausing...");
+            if (service_platform != nullptr)
+                service_platform->set_state_pausing ();
+            advance (pausing_sequence::pause_serving);
+            if (not this_->isSignalConnected (QMetaMethod::fromSignal (& application::pause_serving)))
+            {
+                advance (pausing_sequence::set_state_paused);
+                return proceed_result::continue_;
+            }
+            {
+                check_proceeding_and_lose_control ();
+                const QPointer<const application> this_exists (this_);
+                Q_EMIT this_->pause_serving ();
+                if (this_exists.isNull ())
+                    return proceed_result::destroyed;
+            }
+            return retake_control ();
+        }
+        if (state.state == service_state::paused and state.target_state == target_service_state::serving)
+        {
+            state.state = service_state::resuming;
+            qCInfo (category, "Resuming...");
+            if (service_platform != nullptr)
+                service_platform->set_state_resuming ();
+            advance (pausing_sequence::resume_serving);
+            if (not this_->isSignalConnected (QMetaMethod::fromSignal (& application::resume_serving)))
+            {
+                advance (pausing_sequence::set_state_serving);
+                return proceed_result::continue_;
+            }
+            {
+                check_proceeding_and_lose_control ();
+                const QPointer<const application> this_exists (this_);
+                Q_EMIT this_->resume_serving ();
+                if (this_exists.isNull ())
+                    return proceed_result::destroyed;
+            }
+            return retake_control ();
+        }
+        // Asked to be where it already is.
+        state.target_state = target_service_state::none;
+        return proceed_result::continue_;
+
+        case pausing_sequence::pause_serving :
+        case pausing_sequence::resume_serving : return proceed_result::nothing_to_do;
+
+        case pausing_sequence::set_state_paused :
+        state.state = service_state::paused;
+        if (state.target_state == target_service_state::paused)
+            state.target_state = target_service_state::none;
+        advance (pausing_sequence::none);
+        if (service_platform != nullptr)
+            service_platform->set_state_paused ();
+        qCInfo (category, "Paused.");
+        break;
+
+        case pausing_sequence::set_state_serving :
+        state.state = service_state::serving;
+        if (state.target_state == target_service_state::serving)
+            state.target_state = target_service_state::none;
+        advance (pausing_sequence::none);
+        if (service_platform != nullptr)
+            service_platform->set_state_resumed ();
+        qCInfo (category, "Serving...");
+        break;
+
+        default : Q_UNREACHABLE (); return proceed_result::nothing_to_do;
+    }
+    if (not this_->isSignalConnected (QMetaMethod::fromSignal (& application::state_changed)))
+        return proceed_result::continue_;
+    {
+        check_proceeding_and_lose_control ();
+        const QPointer<const application> this_exists (this_);
+        Q_EMIT this_->state_changed ();
+        if (this_exists.isNull ())
+            return proceed_result::destroyed;
+    }
+    return retake_control ();
+}
+
+// Once serving and until stopping.
+bool application_implementation::pausable () const
+{
+    return
+        starting == starting_sequence::done
+        and stopping == stopping_sequence::none
+        and state.target_state != target_service_state::stopped;
+}
+
 proceed_result application_implementation::process_error ()
 {
     application_error value (std::move (error_.value ()));
@@ -1111,22 +1867,76 @@ proceed_result application_implementation::process_error ()
 }
 
 // May add a user callback for flexibility.
-void application_implementation::process_system_event ()
+proceed_result application_implementation::process_system_event ()
 {
-    const application_system_event event (std::move (system_events.front ()));
-    system_events.pop_front ();
+    const application_system_event event (system_events.pop ());
     switch (event.action)
     {
         case application_system_event::stop :
         state.target_state = target_service_state::stopped;
         qCInfo (category, "Stop on signal: '%s'.", qUtf8Printable (event.name));
         break;
+
+        case application_system_event::reload :
+        if (not state.serving ())
+        {
+            qCInfo (category, "Ignoring reload on signal: '%s'.", qUtf8Printable (event.name));
+            break;
+        }
+        // The handler might have read the configuration already. Any number of requests meanwhile make one more reload.
+        if (reloading == reloading_sequence::reload or reloading == reloading_sequence::reload_again)
+            advance (reloading_sequence::reload_again);
+        else
+            advance (reloading_sequence::requested);
+        qCInfo (category, "Reload on signal: '%s'.", qUtf8Printable (event.name));
+        break;
+
+        case application_system_event::pause :
+        if (not pausable ())
+        {
+            qCInfo (category, "Ignoring pause on signal: '%s'.", qUtf8Printable (event.name));
+            break;
+        }
+        state.target_state = target_service_state::paused;
+        qCInfo (category, "Pause on signal: '%s'.", qUtf8Printable (event.name));
+        break;
+
+        case application_system_event::resume :
+        if (not pausable ())
+        {
+            qCInfo (category, "Ignoring resume on signal: '%s'.", qUtf8Printable (event.name));
+            break;
+        }
+        state.target_state = target_service_state::serving;
+        qCInfo (category, "Resume on signal: '%s'.", qUtf8Printable (event.name));
+        break;
+
+        case application_system_event::memory_pressure_some :
+        case application_system_event::memory_pressure_full :
+        {
+            const bool full (event.action == application_system_event::memory_pressure_full);
+            qCInfo (category, "Memory pressure: '%s'.", full ? "full" : "some");
+            if (stopping != stopping_sequence::none or state.target_state == target_service_state::stopped)
+                break;
+            if (not this_->isSignalConnected (QMetaMethod::fromSignal (& application::memory_pressure)))
+                break;
+            // Whatever else is due is taken up after the handler returns.
+            check_proceeding_and_lose_control ();
+            const QPointer<const application> this_exists (this_);
+            Q_EMIT this_->memory_pressure (full);
+            if (this_exists.isNull ())
+                return proceed_result::destroyed;
+            proceed_from_event_loop ();
+            return retake_control ();
+        }
     }
+    return proceed_result::continue_;
 }
 
 void application_implementation::set_up_event_loop_controller ()
 {
-    const auto plugins (application_implementation::plugins<event_loop_controller_plugin> ());
+    #if not defined background_no_plugins
+    const auto plugins (plugin_registry::instance ().plugins<event_loop_controller_plugin> ());
     event_loop = [& plugins, this] ()
     {
         for (const auto & plugin : plugins)
@@ -1140,6 +1950,9 @@ void application_implementation::set_up_event_loop_controller ()
         }
         return static_cast<event_loop_controller *> (new event_loop_controller_qt (this_));
     } ();
+    #else
+    event_loop = new event_loop_controller_qt (this_);
+    #endif
     QObject::connect (
         event_loop, & event_loop_controller::exiting,
         this_, std::bind (& application_implementation::shut_down_before_application_exits, this)
@@ -1167,25 +1980,35 @@ void application_implementation::process_system_event_received (const applicatio
 {
     if (state.state == service_state::stopped or stopping >= stopping_sequence::exit_application)
         return;
-    system_events.push_back (event);
+    if (event.action == application_system_event::stop and not stop_requested.isValid ())
+        stop_requested.start ();
+    metrics.system_events.fetch_add (1, std::memory_order_relaxed);
+    switch (system_events.push (event))
+    {
+        case system_event_queue::push_result::queued :
+        case system_event_queue::push_result::replaced : break;
+
+        case system_event_queue::push_result::coalesced :
+        metrics.system_events_coalesced.fetch_add (1, std::memory_order_relaxed);
+        return;
+
+        case system_event_queue::push_result::dropped :
+        metrics.system_events_dropped.fetch_add (1, std::memory_order_relaxed);
+        return;
+    }
+    if (system_events.size () > metrics.system_events_high_water_mark.load (std::memory_order_relaxed))
+        metrics.system_events_high_water_mark.store (system_events.size (), std::memory_order_relaxed);
     proceed_from_event_loop ();
 }
 
 void application_implementation::set_up_service_platform ()
 {
-    const auto plugins (
-        [] ()
-        {
-            const auto plugins (application_implementation::plugins<service_platform_plugin> ());
-            std::multimap<unsigned int, service_platform_plugin *> result;
-            for (auto * const plugin : plugins)
-                result.emplace (plugin->order (), plugin);
-            return result;
-        } ()
-    );
+    #if not defined background_no_plugins
+    // Sorted by order.
+    const auto plugins (plugin_registry::instance ().plugins<service_platform_plugin> ());
     service_platform = [& plugins, this] ()
     {
-        for (const auto & [ order, plugin ] : plugins)
+        for (auto * const plugin : plugins)
         {
             if (not plugin->detect ())
                 continue;
@@ -1195,6 +2018,9 @@ void application_implementation::set_up_service_platform ()
         }
         return static_cast<class service_platform *> (nullptr);
     } ();
+    #else
+    service_platform = new built_in_platforms::service_platform (this_);
+    #endif
     if (service_platform == nullptr)
     {
         proceeding = proceeding_state::failed;
@@ -1262,6 +2088,7 @@ void application_implementation::process_service_platform_started ()
 {
     if (starting != starting_sequence::start_service_platform or proceeding != proceeding_state::starting)
         return;
+    trace.instant (lifecycle_trace::platform, QStringLiteral ("service_platform_started"));
     proceeding = proceeding_state::started;
     proceed_from_event_loop ();
 }
@@ -1270,6 +2097,7 @@ void application_implementation::process_service_platform_failed_to_start (const
 {
     if (starting != starting_sequence::start_service_platform or proceeding != proceeding_state::starting)
         return;
+    trace.instant (lifecycle_trace::platform, QStringLiteral ("service_platform_failed_to_start"));
     proceeding = proceeding_state::failed;
     error_ = error;
     proceed_from_event_loop ();
@@ -1279,6 +2107,7 @@ void application_implementation::process_service_platform_stopped ()
 {
     if (stopping != stopping_sequence::stop_service_platform or proceeding != proceeding_state::stopping)
         return;
+    trace.instant (lifecycle_trace::platform, QStringLiteral ("service_platform_stopped"));
     proceeding = proceeding_state::stopped;
     proceed_from_event_loop ();
 }
@@ -1287,6 +2116,7 @@ void application_implementation::process_service_state_serving_set ()
 {
     if (starting != starting_sequence::set_service_state_serving or proceeding != proceeding_state::starting)
         return;
+    trace.instant (lifecycle_trace::platform, QStringLiteral ("service_state_serving_set"));
     proceeding = proceeding_state::started;
     proceed_from_event_loop ();
 }
@@ -1295,6 +2125,7 @@ void application_implementation::process_failed_to_set_service_state_serving (co
 {
     if (starting != starting_sequence::set_service_state_serving or proceeding != proceeding_state::starting)
         return;
+    trace.instant (lifecycle_trace::platform, QStringLiteral ("failed_to_set_service_state_serving"));
     proceeding = proceeding_state::failed;
     error_ = error;
     proceed_from_event_loop ();
@@ -1304,6 +2135,7 @@ void application_implementation::process_service_state_stopping_set ()
 {
     if (stopping != stopping_sequence::set_service_state_stopping or proceeding != proceeding_state::stopping)
         return;
+    trace.instant (lifecycle_trace::platform, QStringLiteral ("service_state_stopping_set"));
     proceeding = proceeding_state::stopped;
     proceed_from_event_loop ();
 }
@@ -1312,6 +2144,7 @@ void application_implementation::process_service_state_stopped_set ()
 {
     if (stopping != stopping_sequence::set_service_state_stopped or proceeding != proceeding_state::stopping)
         return;
+    trace.instant (lifecycle_trace::platform, QStringLiteral ("service_state_stopped_set"));
     proceeding = proceeding_state::stopped;
     proceed_from_event_loop ();
 }
@@ -1320,6 +2153,7 @@ void application_implementation::process_service_configuration_retrieved (const
 {
     if (starting != starting_sequence::retrieve_service_configuration or proceeding != proceeding_state::starting)
         return;
+    trace.instant (lifecycle_trace::platform, QStringLiteral ("service_configuration_retrieved"));
     proceeding = proceeding_state::started;
     service_configuration = configuration;
     proceed_from_event_loop ();
@@ -1329,6 +2163,7 @@ void application_implementation::process_failed_to_retrieve_service_configuratio
 {
     if (starting != starting_sequence::retrieve_service_configuration or proceeding != proceeding_state::starting)
         return;
+    trace.instant (lifecycle_trace::platform, QStringLiteral ("failed_to_retrieve_service_configuration"));
     proceeding = proceeding_state::failed;
     error_ = error;
     proceed_from_event_loop ();
@@ -1336,19 +2171,12 @@ void application_implementation::process_failed_to_retrieve_service_configuratio
 
 void application_implementation::set_up_console_platform ()
 {
-    const auto plugins (
-        [] ()
-        {
-            const auto plugins (application_implementation::plugins<console_platform_plugin> ());
-            std::multimap<unsigned int, console_platform_plugin *> result;
-            for (auto * const plugin : plugins)
-                result.emplace (plugin->order (), plugin);
-            return result;
-        } ()
-    );
+    #if not defined background_no_plugins
+    // Sorted by order.
+    const auto plugins (plugin_registry::instance ().plugins<console_platform_plugin> ());
     console_platform = [& plugins, this] ()
     {
-        for (const auto & [ order, plugin ] : plugins)
+        for (auto * const plugin : plugins)
         {
             auto * const result (plugin->create (this_));
             if (result != nullptr)
@@ -1356,6 +2184,9 @@ void application_implementation::set_up_console_platform ()
         }
         return static_cast<class console_platform *> (nullptr);
     } ();
+    #else
+    console_platform = new built_in_platforms::console_platform (this_);
+    #endif
     if (console_platform == nullptr)
     {
         proceeding = proceeding_state::failed;
@@ -1389,6 +2220,7 @@ void application_implementation::process_console_platform_started ()
 {
     if (starting != starting_sequence::start_console_platform or proceeding != proceeding_state::starting)
         return;
+    trace.instant (lifecycle_trace::platform, QStringLiteral ("console_platform_started"));
     proceeding = proceeding_state::started;
     proceed_from_event_loop ();
 }
@@ -1397,6 +2229,7 @@ void application_implementation::process_console_platform_failed_to_start (const
 {
     if (starting != starting_sequence::start_console_platform or proceeding != proceeding_state::starting)
         return;
+    trace.instant (lifecycle_trace::platform, QStringLiteral ("console_platform_failed_to_start"));
     proceeding = proceeding_state::failed;
     error_ = error;
     proceed_from_event_loop ();
@@ -1406,28 +2239,366 @@ void application_implementation::process_console_platform_stopped ()
 {
     if (stopping != stopping_sequence::stop_console_platform or proceeding != proceeding_state::stopping)
         return;
+    trace.instant (lifecycle_trace::platform, QStringLiteral ("console_platform_stopped"));
     proceeding = proceeding_state::stopped;
     proceed_from_event_loop ();
 }
 
-template <class T> std::vector<T *> application_implementation::plugins ()
+// A keepalive sent from a thread of its own would report a wedged event loop as healthy.
+// The timer is only as late as the event loop is busy, so lagging too far behind withholds the keepalive
+// and lets the system restart the service.
+void application_implementation::start_watchdog ()
+{
+    watchdog_interval = service_platform->watchdog_interval ();
+    if (watchdog_interval <= std::chrono::microseconds::zero ())
+        return;
+    if (watchdog == nullptr)
+    {
+        watchdog = new QTimer (this_);
+        watchdog->setTimerType (Qt::PreciseTimer);
+        QObject::connect (
+            watchdog, & QTimer::timeout,
+            this_, std::bind (& application_implementation::keep_alive, this)
+        );
+    }
+    qCInfo (category, "Keeping the service alive every %lld ms.", static_cast<long long> (watchdog_interval.count () / 2000));
+    watchdog->setInterval (std::chrono::duration_cast<std::chrono::milliseconds> (watchdog_interval / 2));
+    watchdog->start ();
+    watchdog_elapsed.start ();
+    service_platform->keep_alive ();
+}
+
+void application_implementation::stop_watchdog ()
+{
+    if (watchdog == nullptr)
+        return;
+    watchdog->stop ();
+}
+
+void application_implementation::keep_alive ()
+{
+    // Against the period, not the watchdog interval: a keepalive a whole interval late is one the service manager already missed.
+    const auto period (watchdog->intervalAsDuration ());
+    const auto lag (std::chrono::milliseconds (watchdog_elapsed.restart ()) - period);
+    if (lag > std::chrono::duration<double, std::milli> (period) * watchdog_tolerance)
+    {
+        qCWarning (category, "The event loop lags behind by %lld ms. Not keeping the service alive.", static_cast<long long> (lag.count ()));
+        return;
+    }
+    service_platform->keep_alive ();
+}
+
+void application_implementation::start_deadline (const std::chrono::milliseconds timeout, const QString & name)
+{
+    progress_elapsed.invalidate ();
+    if (progress != nullptr)
+        progress->stop ();
+    if (timeout <= std::chrono::milliseconds::zero ())
+    {
+        deadline = QDeadlineTimer (QDeadlineTimer::Forever);
+        guard.disarm ();
+        return;
+    }
+    deadline = QDeadlineTimer (timeout);
+    guard.arm (deadline, name, timeout_exit_code);
+}
+
+void application_implementation::stop_deadline ()
+{
+    progress_elapsed.invalidate ();
+    if (progress != nullptr)
+        progress->stop ();
+    deadline = QDeadlineTimer (QDeadlineTimer::Forever);
+    guard.disarm ();
+}
+
+void application_implementation::report_progress ()
+{
+    if (state.state != service_state::starting and state.state != service_state::stopping)
+        return;
+    // Passed on right away the first time in a while: the handler reporting might as well be blocking the event loop.
+    // Otherwise, the latest report is passed on after the interval.
+    if (not progress_elapsed.isValid () or progress_elapsed.hasExpired (std::chrono::milliseconds (progress_interval).count ()))
+    {
+        extend_timeout ();
+        return;
+    }
+    if (progress == nullptr)
+    {
+        progress = new QTimer (this_);
+        progress->setSingleShot (true);
+        QObject::connect (
+            progress, & QTimer::timeout,
+            this_, std::bind (& application_implementation::extend_timeout, this)
+        );
+    }
+    if (progress->isActive ())
+        return;
+    progress->start (progress_interval - std::chrono::milliseconds (progress_elapsed.elapsed ()));
+}
+
+void application_implementation::extend_timeout ()
+{
+    progress_elapsed.start ();
+    if (service_platform == nullptr or not running_as_service.value_or (false))
+        return;
+    std::chrono::microseconds timeout (progress_extension);
+    if (not deadline.isForever ())
+        timeout = std::min (timeout, std::chrono::duration_cast<std::chrono::microseconds> (deadline.remainingTimeAsDuration ()));
+    service_platform->extend_timeout (timeout);
+}
+
+// Destroying a large heap only touches the pages to give them back, which the system does anyway.
+// Nothing is destroyed past this point, so whatever buffers output has to be flushed explicitly.
+void application_implementation::exit_fast ()
+{
+    qCInfo (category, "Exit fast with the result: '%d'.", exit_code);
+    if (fast_exit_timeout > std::chrono::milliseconds::zero ())
+        guard.arm (QDeadlineTimer (fast_exit_timeout), QStringLiteral ("flush"), exit_code);
+    for (const auto & flush : exit_flushes)
+        flush ();
+    std::fflush (nullptr);
+    std::_Exit (exit_code);
+}
+
+void application_implementation::start_memory_pressure_monitor ()
+{
+    if (
+        memory_pressure_threshold.some <= std::chrono::microseconds::zero ()
+        and memory_pressure_threshold.full <= std::chrono::microseconds::zero ()
+    )
+        return;
+    if (memory_pressure == nullptr)
+    {
+        memory_pressure = new memory_pressure_monitor (this_);
+        QObject::connect (
+            memory_pressure, & memory_pressure_monitor::crossed,
+            this_,
+            [this] (const bool full)
+            {
+                process_system_event_received (
+                    application_system_event
+                    { // c++20 designated initializers
+                        /*.action = */full ? application_system_event::memory_pressure_full : application_system_event::memory_pressure_some,
+                        /*.name = */QStringLiteral ("memory pressure")
+                    }
+                );
+            }
+        );
+    }
+    // Not a reason to stop serving.
+    if (not memory_pressure->start (memory_pressure_threshold))
+        qCWarning (category).noquote () << text::with_last_error (QStringLiteral (
+            "Failed to watch the memory pressure"
+        ));
+}
+
+void application_implementation::inherit_upgrade ()
+{
+    const auto take = [this] (const QString & name) -> std::optional<qintptr>
+    {
+        const auto descriptor (
+            std::find_if (
+                inherited_descriptors.cbegin (), inherited_descriptors.cend (),
+                [& name] (const inherited_descriptor & descriptor) { return descriptor.name == name; }
+            )
+        );
+        if (descriptor == inherited_descriptors.cend ())
+            return std::nullopt;
+        const auto result (descriptor->descriptor);
+        inherited_descriptors.erase (descriptor);
+        return result;
+    };
+    upgrade_ready = take (upgrade_process::ready_name ());
+    if (const auto state (take (upgrade_process::state_name ())); state.has_value ())
+        upgrade_state = upgrade_process::read_state (state.value ());
+    if (upgrade_ready.has_value ())
+        qCInfo (category, "Upgrading from the previous instance.");
+}
+
+void application_implementation::process_upgrade_finished (const bool ready)
+{
+    if (not ready)
+    {
+        qCWarning (category, "Failed to upgrade: the new instance exited without serving.");
+        if (stopping == stopping_sequence::none)
+            Q_EMIT this_->upgrade_failed ();
+        return;
+    }
+    // A stop requested meanwhile goes on as usual.
+    if (stopping != stopping_sequence::none or state.target_state == target_service_state::stopped)
+        return;
+    upgraded = true;
+    if (service_platform != nullptr)
+        service_platform->set_main_process_id (upgrade->process_id ());
+    process_system_event_received (
+        application_system_event
+        { // c++20 designated initializers
+            /*.action = */application_system_event::stop,
+            /*.name = */QStringLiteral ("upgrade")
+        }
+    );
+}
+
+void application_implementation::stop_memory_pressure_monitor ()
+{
+    if (memory_pressure == nullptr)
+        return;
+    memory_pressure->stop ();
+}
+
+// Either task handles both signals, so that stopping waits for the start task whichever is set.
+void application_implementation::set_up_tasks ()
+{
+    if (start_task_watcher != nullptr)
+        return;
+    start_task_watcher = new QFutureWatcher<bool> (this_);
+    stop_task_watcher = new QFutureWatcher<void> (this_);
+    QObject::connect (
+        start_task_watcher, & QFutureWatcher<bool>::finished,
+        this_, [this] () { process_start_task_finished (); }
+    );
+    QObject::connect (
+        stop_task_watcher, & QFutureWatcher<void>::finished,
+        this_, [this] () { process_stop_task_finished (); }
+    );
+    QObject::connect (this_, & application::start, this_, [this] () { run_start_task (); });
+    QObject::connect (this_, & application::stop, this_, [this] () { run_stop_task (); });
+}
+
+// The promise is shared with the runnable, as it is not copyable.
+// The task is copied, so that nothing here is touched from the thread pool.
+void application_implementation::run_start_task ()
+{
+    if (not start_task)
+    {
+        this_->set_started ();
+        return;
+    }
+    const auto promise (std::make_shared<QPromise<bool>> ());
+    start_task_future = promise->future ();
+    promise->start ();
+    start_task_watcher->setFuture (start_task_future);
+    this_->task_thread_pool ()->start (
+        [promise, task = start_task] ()
+        {
+            // Thrown out of the thread of the pool, it would terminate the process.
+            bool started (false);
+            try
+            {
+                started = task ();
+            }
+            catch (...)
+            {}
+            promise->addResult (started);
+            promise->finish ();
+        }
+    );
+}
+
+// Canceled, there is no result.
+void application_implementation::process_start_task_finished ()
+{
+    if (stop_task_pending)
+    {
+        stop_task_pending = false;
+        run_stop_task ();
+        return;
+    }
+    if (start_task_future.resultCount () > 0 and start_task_future.result ())
+        this_->set_started ();
+    else
+        this_->set_failed_to_start ();
+}
+
+// The start task can not be interrupted, only asked to return early.
+void application_implementation::run_stop_task ()
 {
-    const auto interface_id (QString::fromUtf8 (qobject_interface_iid<T *> ()));
-    std::vector<T *> result;
-    const auto plugins (QPluginLoader::staticPlugins ());
-    for (const auto & plugin : plugins)
+    if (start_task_future.isRunning ())
     {
-        if (plugin.metaData ().value (QStringLiteral ("IID")).toString () != interface_id)
-            continue;
-        QObject * const instance_ (plugin.instance ());
-        if (instance_ == nullptr)
-            continue;
-        auto * const instance (qobject_cast<T *> (instance_));
-        if (instance == nullptr)
-            continue;
-        result.push_back (instance);
+        start_task_future.cancel ();
+        stop_task_pending = true;
+        return;
     }
+    if (not stop_task)
+    {
+        this_->set_stopped ();
+        return;
+    }
+    const auto promise (std::make_shared<QPromise<void>> ());
+    stop_task_future = promise->future ();
+    promise->start ();
+    stop_task_watcher->setFuture (stop_task_future);
+    this_->task_thread_pool ()->start (
+        [promise, task = stop_task] ()
+        {
+            try
+            {
+                task ();
+            }
+            catch (...)
+            {}
+            promise->finish ();
+        }
+    );
+}
+
+void application_implementation::process_stop_task_finished ()
+{
+    this_->set_stopped ();
+}
+
+namespace
+{
+
+proceed_event::proceed_event ()
+    : QEvent (type ())
+{}
+
+QEvent::Type proceed_event::type ()
+{
+    static const auto result (static_cast<Type> (QEvent::registerEventType ()));
     return result;
 }
 
+void * proceed_event::operator new (const std::size_t size)
+{
+    if (size == sizeof (proceed_event) and not proceed_event_stored.exchange (true, std::memory_order_acquire))
+        return proceed_event_storage;
+    // Should 'application' ever be misused, such as with more than one instance.
+    return ::operator new (size);
+}
+
+void proceed_event::operator delete (void * const pointer)
+{
+    if (pointer == proceed_event_storage)
+    {
+        proceed_event_stored.store (false, std::memory_order_release);
+        return;
+    }
+    ::operator delete (pointer);
+}
+
+QString name (const starting_sequence value)
+{
+    return QString::fromUtf8 (starting_table.name (value));
+}
+
+QString name (const stopping_sequence value)
+{
+    return QString::fromUtf8 (stopping_table.name (value));
+}
+
+// Asserted while debugging. Otherwise logged, and taken anyway: the switches are what proceed.
+template <class table, class sequence>
+void check_transition (const table & table_, const sequence from, const sequence to)
+{
+    if (table_.allows (from, to))
+        return;
+    qCCritical (category, "Unexpected transition from '%s' to '%s'.", table_.name (from), table_.name (to));
+    assert (false);
+}
+
+} // namespace
+
 } // namespace background
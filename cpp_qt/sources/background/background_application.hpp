@@ -1,6 +1,15 @@
 #pragma once
 
+#include <chrono>
+#include <functional>
+#include <vector>
+
 #include <QtCore/QObject>
+#include <QtCore/QDeadlineTimer>
+#include <QtCore/QStringList>
+#include <QtCore/QFuture>
+
+class QThreadPool;
 
 #include "background_library.hpp"
 #include "background_datatypes_forward.hpp"
@@ -19,22 +28,46 @@ class background_library application : public QObject
     public Q_SLOTS :
     void run ();
     void shut_down ();
+    // Holds the work off without stopping, and takes it up again.
+    void pause ();
+    void resume ();
 
     Q_SIGNALS :
     void start ();
     void stop ();
+    // Asked by the system while serving. To be acknowledged with 'set_reloaded ()'.
+    void reload ();
+    // To be acknowledged with 'set_paused ()' and 'set_resumed ()'.
+    void pause_serving ();
+    void resume_serving ();
 
     void state_changed ();
 
+    // The processors available to the process changed, such as the quota of the control group.
+    void cpu_budget_changed ();
+
+    // The system is running low on memory. Only while serving and with a threshold set.
+    void memory_pressure (bool full);
+
+    // The new instance exited or closed the descriptors without serving. Still serving here.
+    void upgrade_failed ();
+
     void failed ();
 
     public Q_SLOTS :
     void set_started ();
     void set_failed_to_start ();
     void set_stopped ();
+    void set_reloaded ();
+    void set_paused ();
+    void set_resumed ();
 
     void ignore_error ();
 
+    // Keeps the system waiting while a long start or stop is making progress.
+    // Does not move the start or stop timeout set here.
+    void report_progress ();
+
     public :
     serving_state state () const;
 
@@ -45,9 +78,58 @@ class background_library application : public QObject
 
     const std::optional<application_error> & error () const;
 
+    // Available before 'start ()' is emitted.
+    const std::vector<inherited_descriptor> & inherited_descriptors () const;
+    std::optional<qintptr> take_inherited_descriptor (const QString & name);
+
+    // Parks a descriptor with the service manager, to be inherited by the next instance under the name.
+    // Such as an accepted connection or a memory file with a cache. The descriptor is duplicated.
+    // Only while running as a service, until the service platform is stopped.
+    bool store_descriptor (const QString & name, qintptr descriptor);
+    bool discard_stored_descriptor (const QString & name);
+
+    // Hands serving over to a new instance of the program without a service manager, only while serving.
+    // The descriptors, such as the listening sockets, are passed same as with socket activation, along with the state.
+    // Once the new instance is serving, this one stops: the stop handler drains and closes the connections.
+    // False if the new instance could not be started. POSIX only.
+    bool upgrade (
+        const QString & program, const QStringList & arguments,
+        const std::vector<inherited_descriptor> & descriptors, const QByteArray & state = {}
+    );
+    // In the new instance, the state passed by the previous one. Available before 'start ()' is emitted.
+    QByteArray take_upgrade_state ();
+
     int exit_code () const;
     void set_exit_code (int exit_code);
 
+    // The number of processors the process may keep busy, fractional under a quota.
+    // Unlike 'QThread::idealThreadCount ()', limited by the affinity and the control group of the process.
+    // Kept up to date while running.
+    double cpu_budget () const;
+    // The budget rounded up, at least one. To size worker pools with.
+    int ideal_thread_count () const;
+
+    // Called in the order added right before the fast exit, such as to flush a log file.
+    void add_exit_flush (std::function<void ()> flush);
+
+    // Counters and durations of the lifecycle. May be read from any thread for as long as this exists.
+    const application_metrics & metrics () const;
+
+    // The steps of starting and stopping, the handlers and the platform callbacks so far,
+    // in the trace event format of Chrome, to be loaded in Perfetto.
+    QByteArray trace () const;
+    // The steps of starting, stopping, reloading and pausing and the transitions between them, in the DOT format of Graphviz.
+    static QString lifecycle_graph ();
+
+    // The time left to start or to stop serving, to shorten the work accordingly.
+    // Forever when not bounded.
+    QDeadlineTimer deadline () const;
+
+    // The futures of the tasks set, valid once run. May be read from the tasks.
+    // The one of the start task is canceled on stopping while starting, for the task to poll 'isCanceled ()'.
+    QFuture<bool> start_task_future () const;
+    QFuture<void> stop_task_future () const;
+
     public :
     bool with_stop_starting () const;
     application & set_with_stop_starting ();
@@ -59,6 +141,44 @@ class background_library application : public QObject
     application & set_no_running_as_service ();
     bool no_running_as_console_application () const;
     application & set_no_running_as_console_application ();
+    // How late a keepalive may come, as a fraction of the period it is sent with, half the watchdog interval.
+    // Later, the event loop is taken as stalled and the keepalive is withheld, for the service manager to act on it.
+    double watchdog_tolerance () const;
+    application & set_watchdog_tolerance (double fraction);
+    // Zero for no timeout. Once passed, the process exits right away with the timeout exit code.
+    // The timeouts of the system are only available over a bus: set these to match.
+    std::chrono::milliseconds start_timeout () const;
+    application & set_start_timeout (std::chrono::milliseconds timeout);
+    std::chrono::milliseconds stop_timeout () const;
+    application & set_stop_timeout (std::chrono::milliseconds timeout);
+    int timeout_exit_code () const;
+    application & set_timeout_exit_code (int exit_code);
+    // Proceeds right away after a handler that is done once it returns, instead of through the event loop.
+    // Cuts the event loop iterations of starting and stopping to the ones the platforms and the handlers take.
+    bool with_synchronous_proceeding () const;
+    application & set_with_synchronous_proceeding ();
+    // Where to write the trace at exit. Not written when empty.
+    const QString & trace_file () const;
+    application & set_trace_file (const QString & path);
+    // Once stopped, the process exits with the exit code right away, without destroying anything.
+    // Only the flushes added and the standard streams are flushed, within the timeout. Zero for no timeout.
+    bool with_fast_exit () const;
+    application & set_with_fast_exit ();
+    std::chrono::milliseconds fast_exit_timeout () const;
+    application & set_fast_exit_timeout (std::chrono::milliseconds timeout);
+    const pressure_threshold & memory_pressure_threshold () const;
+    application & set_memory_pressure_threshold (const pressure_threshold & threshold);
+    // Run on the thread pool instead of handlers of 'start ()' and 'stop ()', so that the event loop is not held up:
+    // set started or failed to start as the start task returns true or false, and stopped as the stop task returns.
+    // Stopping waits for the start task to return. Not to be combined with handlers of 'start ()' or 'stop ()'.
+    application & set_start_task (std::function<bool ()> task);
+    application & set_stop_task (std::function<void ()> task);
+    // The global instance when not set.
+    QThreadPool * task_thread_pool () const;
+    application & set_task_thread_pool (QThreadPool * pool);
+
+    protected :
+    bool event (QEvent * event) override;
 
     private :
     Q_OBJECT
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <QtCore/QtGlobal>
+
+#if defined Q_OS_LINUX
+#include "background_service_platform_systemd.hpp"
+#include "background_console_platform_posix.hpp"
+#elif defined Q_OS_WIN
+#include "background_service_platform_windows.hpp"
+#include "background_console_platform_windows.hpp"
+#endif
+
+namespace background
+{
+
+template <class service_platform_type, class console_platform_type>
+struct platforms
+{
+    using service_platform = service_platform_type;
+    using console_platform = console_platform_type;
+};
+
+// The platforms of the system the library is built for.
+// Created directly when the library is built without plugins.
+#if defined Q_OS_LINUX
+using built_in_platforms = platforms<service_platform_systemd, console_platform_posix>;
+#elif defined Q_OS_WIN
+using built_in_platforms = platforms<service_platform_windows, console_platform_windows>;
+#endif
+
+} // namespace background
@@ -0,0 +1,112 @@
+#include "background_console_platform_posix.hpp"
+
+#include <signal.h>
+
+#include <QtCore/QtPlugin>
+
+#include "background_datatypes.hpp"
+#include "background_signal_notifier_posix.hpp"
+
+namespace background
+{
+
+namespace
+{
+
+application_error failed_to_subscribe_to_events ();
+
+} // namespace
+
+console_platform_posix::console_platform_posix (QObject * const parent)
+    : console_platform (parent),
+    notifier (new signal_notifier_posix (this))
+{}
+
+console_platform_posix::~console_platform_posix ()
+{}
+
+void console_platform_posix::start ()
+{
+    connect (
+        notifier, & signal_notifier_posix::received,
+        this, & console_platform_posix::process_event
+    );
+    // Taking 'SIGTSTP' keeps the process running, paused, instead of being stopped by the terminal.
+    // 'SIGCONT' continues the process whether handled or not.
+    if (not notifier->start ({ SIGINT, SIGTERM, SIGHUP, SIGQUIT, SIGTSTP, SIGCONT }))
+    {
+        Q_EMIT failed_to_start (failed_to_subscribe_to_events ());
+        return;
+    }
+    Q_EMIT started ();
+}
+
+void console_platform_posix::stop ()
+{
+    // Past this point the signals are handled by default again and terminate the process.
+    notifier->stop ();
+    Q_EMIT stopped ();
+}
+
+void console_platform_posix::process_event (const int number)
+{
+    const auto action = [] (const int number)
+    {
+        switch (number)
+        {
+            // The terminal is gone for 'SIGHUP', but daemons conventionally take it to reload.
+            case SIGHUP : return application_system_event::reload;
+            case SIGTSTP : return application_system_event::pause;
+            case SIGCONT : return application_system_event::resume;
+            default : return application_system_event::stop;
+        }
+    };
+    Q_EMIT event_received (
+        application_system_event
+        { // c++20 designated initializers
+            /*.action = */action (number),
+            /*.name = */signal_notifier_posix::name (number)
+        }
+    );
+}
+
+namespace
+{
+
+application_error failed_to_subscribe_to_events ()
+{
+    return application_error
+    { // c++20 designated initializers
+        /*.error =*/application_error::failed_to_run,
+        /*.text =*/text::with_last_error (QStringLiteral (
+            "Failed to run as a console application. "
+            "Failed to subscribe to console events"
+        ))
+    };
+}
+
+} // namespace
+
+#if not defined background_no_plugins
+
+background_console_platform_plugin_posix::background_console_platform_plugin_posix (QObject * const parent)
+    : console_platform_plugin (parent)
+{}
+
+unsigned int background_console_platform_plugin_posix::order () const
+{
+    return 99;
+}
+
+console_platform * background_console_platform_plugin_posix::create (QObject * const parent)
+{
+    return new console_platform_posix (parent);
+}
+
+#endif
+
+} // namespace background
+
+#if not defined background_no_plugins
+Q_IMPORT_PLUGIN (background_console_platform_plugin_posix)
+#endif
@@ -0,0 +1,55 @@
+#pragma once
+
+#if not defined QT_STATICPLUGIN and not defined background_no_plugins
+#define QT_STATICPLUGIN
+#endif
+
+#include "background_console_platform.hpp"
+
+namespace background
+{
+
+class signal_notifier_posix;
+
+class console_platform_posix : public console_platform
+{
+    public :
+    explicit console_platform_posix (QObject * parent);
+    ~console_platform_posix ();
+
+    public Q_SLOTS :
+    void start () override;
+    void stop () override;
+
+    protected Q_SLOTS :
+    void process_event (int number);
+
+    private :
+    signal_notifier_posix * const notifier;
+
+    private :
+    Q_OBJECT
+    Q_DISABLE_COPY (console_platform_posix)
+};
+
+#if not defined background_no_plugins
+
+class background_console_platform_plugin_posix : public console_platform_plugin
+{
+    public :
+    explicit background_console_platform_plugin_posix (QObject * parent = nullptr);
+
+    public :
+    unsigned int order () const override;
+    console_platform * create (QObject * parent = nullptr) override;
+
+    private :
+    Q_OBJECT
+    Q_DISABLE_COPY (background_console_platform_plugin_posix)
+    Q_PLUGIN_METADATA (IID "background.console_platform_plugin")
+    Q_INTERFACES (background::console_platform_plugin)
+};
+
+#endif
+
+} // namespace background
@@ -251,6 +251,8 @@ application_error failed_to_subscribe_to_events ()
 
 } // namespace
 
+#if not defined background_no_plugins
+
 background_console_platform_plugin_windows::background_console_platform_plugin_windows (QObject * const parent)
     : console_platform_plugin (parent)
 {}
@@ -265,6 +267,10 @@ console_platform * background_console_platform_plugin_windows::create (QObject *
     return new console_platform_windows (parent);
 }
 
+#endif
+
 } // namespace background
 
+#if not defined background_no_plugins
 Q_IMPORT_PLUGIN (background_console_platform_plugin_windows)
+#endif
@@ -1,6 +1,6 @@
 #pragma once
 
-#if not defined QT_STATICPLUGIN
+#if not defined QT_STATICPLUGIN and not defined background_no_plugins
 #define QT_STATICPLUGIN
 #endif
 
@@ -30,6 +30,8 @@ class console_platform_windows : public console_platform
     Q_DISABLE_COPY (console_platform_windows)
 };
 
+#if not defined background_no_plugins
+
 class background_console_platform_plugin_windows : public console_platform_plugin
 {
     public :
@@ -46,4 +48,6 @@ class background_console_platform_plugin_windows : public console_platform_plugi
     Q_INTERFACES (background::console_platform_plugin)
 };
 
+#endif
+
 } // namespace background
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <QtCore/QObject>
+
+class QFileSystemWatcher;
+
+namespace background
+{
+
+// The number of processors the process may keep busy, as limited by the system.
+// Fractional under a quota. Read on demand and kept up to date while watching.
+class cpu_budget_monitor : public QObject
+{
+    public :
+    explicit cpu_budget_monitor (QObject * parent);
+    ~cpu_budget_monitor ();
+
+    public :
+    double budget ();
+    void start ();
+    void stop ();
+
+    Q_SIGNALS :
+    void changed ();
+
+    protected Q_SLOTS :
+    void update ();
+
+    private :
+    double read ();
+
+    private :
+    QFileSystemWatcher * watcher;
+    double budget_;
+
+    private :
+    Q_OBJECT
+    Q_DISABLE_COPY (cpu_budget_monitor)
+};
+
+} // namespace background
@@ -0,0 +1,177 @@
+#include "background_cpu_budget_monitor.hpp"
+
+#include <algorithm>
+
+#include <sched.h>
+
+#include <QtCore/QFile>
+#include <QtCore/QFileSystemWatcher>
+#include <QtCore/QThread>
+
+namespace background
+{
+
+namespace
+{
+
+QStringList control_groups ();
+QByteArray read_file (const QString & path);
+double quota (const QByteArray & value);
+int count_processors (const QByteArray & value);
+
+} // namespace
+
+cpu_budget_monitor::cpu_budget_monitor (QObject * const parent)
+    : QObject (parent),
+    watcher (nullptr),
+    budget_ (0)
+{}
+
+cpu_budget_monitor::~cpu_budget_monitor ()
+{}
+
+double cpu_budget_monitor::budget ()
+{
+    if (budget_ <= 0)
+        budget_ = read ();
+    return budget_;
+}
+
+void cpu_budget_monitor::start ()
+{
+    if (watcher != nullptr)
+        return;
+    budget_ = read ();
+    const auto groups (control_groups ());
+    if (groups.isEmpty ())
+        return;
+    // The quota of every control group up the tree applies. The effective processor set is already resolved.
+    // Writing the files raises 'inotify' events like with any other file.
+    QStringList paths;
+    paths.append (groups.first () + QStringLiteral ("/cpuset.cpus.effective"));
+    for (const auto & group : groups)
+        paths.append (group + QStringLiteral ("/cpu.max"));
+    paths.erase (
+        std::remove_if (
+            paths.begin (), paths.end (),
+            [] (const QString & path) { return not QFile::exists (path); }
+        ),
+        paths.end ()
+    );
+    if (paths.isEmpty ())
+        return;
+    watcher = new QFileSystemWatcher (paths, this);
+    connect (watcher, & QFileSystemWatcher::fileChanged, this, & cpu_budget_monitor::update);
+}
+
+void cpu_budget_monitor::stop ()
+{
+    delete watcher;
+    watcher = nullptr;
+}
+
+void cpu_budget_monitor::update ()
+{
+    const auto value (read ());
+    if (qFuzzyCompare (value, budget_))
+        return;
+    budget_ = value;
+    Q_EMIT changed ();
+}
+
+double cpu_budget_monitor::read ()
+{
+    // What the scheduler lets the process run on.
+    double result (QThread::idealThreadCount ());
+    cpu_set_t set;
+    if (::sched_getaffinity (0, sizeof (set), & set) == 0)
+        result = std::min (result, static_cast<double> (CPU_COUNT (& set)));
+
+    const auto groups (control_groups ());
+    if (groups.isEmpty ())
+        return result;
+    const auto processors (count_processors (read_file (groups.first () + QStringLiteral ("/cpuset.cpus.effective"))));
+    if (processors > 0)
+        result = std::min (result, static_cast<double> (processors));
+    for (const auto & group : groups)
+    {
+        const auto value (quota (read_file (group + QStringLiteral ("/cpu.max"))));
+        if (value > 0)
+            result = std::min (result, value);
+    }
+    return result;
+}
+
+namespace
+{
+
+// Only the unified hierarchy of cgroup v2, as '0::/path'.
+// The control group of the process first, then those above it, except for the root one.
+QStringList control_groups ()
+{
+    const auto lines (read_file (QStringLiteral ("/proc/self/cgroup")).split ('\n'));
+    for (const auto & line : lines)
+    {
+        if (not line.startsWith ("0::"))
+            continue;
+        QStringList result;
+        const auto names (QString::fromUtf8 (line.mid (3)).split ('/', Qt::SkipEmptyParts));
+        QString path (QStringLiteral ("/sys/fs/cgroup"));
+        for (const auto & name : names)
+        {
+            path.append ('/').append (name);
+            result.prepend (path);
+        }
+        return result;
+    }
+    return {};
+}
+
+QByteArray read_file (const QString & path)
+{
+    QFile file (path);
+    if (not file.open (QIODevice::ReadOnly))
+        return {};
+    return file.readAll ().trimmed ();
+}
+
+// '$MAX $PERIOD', or 'max $PERIOD' for no limit.
+double quota (const QByteArray & value)
+{
+    const auto parts (value.split (' '));
+    if (parts.size () != 2)
+        return 0;
+    bool valid (false);
+    const auto maximum (parts.at (0).toDouble (& valid));
+    if (not valid)
+        return 0;
+    const auto period (parts.at (1).toDouble (& valid));
+    if (not valid or period <= 0)
+        return 0;
+    return maximum / period;
+}
+
+// A list of ranges, as '0-3,8,10-11'.
+int count_processors (const QByteArray & value)
+{
+    int result (0);
+    const auto ranges (value.split (','));
+    for (const auto & range : ranges)
+    {
+        if (range.isEmpty ())
+            continue;
+        const auto bounds (range.split ('-'));
+        bool valid_1 (false);
+        bool valid_2 (true);
+        const auto first (bounds.at (0).toInt (& valid_1));
+        const auto last (bounds.size () > 1 ? bounds.at (1).toInt (& valid_2) : first);
+        if (not valid_1 or not valid_2 or last < first)
+            return 0;
+        result += last - first + 1;
+    }
+    return result;
+}
+
+} // namespace
+
+} // namespace background
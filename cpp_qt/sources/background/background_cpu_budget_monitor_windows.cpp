@@ -0,0 +1,68 @@
+#include "background_cpu_budget_monitor.hpp"
+
+#include <algorithm>
+
+#include <QtCore/QThread>
+#include <QtCore/qt_windows.h>
+
+namespace background
+{
+
+// A job object may cap the processor rate, though without notifying of changes.
+// Read once.
+
+cpu_budget_monitor::cpu_budget_monitor (QObject * const parent)
+    : QObject (parent),
+    watcher (nullptr),
+    budget_ (0)
+{}
+
+cpu_budget_monitor::~cpu_budget_monitor ()
+{}
+
+double cpu_budget_monitor::budget ()
+{
+    if (budget_ <= 0)
+        budget_ = read ();
+    return budget_;
+}
+
+void cpu_budget_monitor::start ()
+{}
+
+void cpu_budget_monitor::stop ()
+{}
+
+void cpu_budget_monitor::update ()
+{}
+
+double cpu_budget_monitor::read ()
+{
+    double result (QThread::idealThreadCount ());
+    DWORD_PTR process_mask (0);
+    DWORD_PTR system_mask (0);
+    if (GetProcessAffinityMask (GetCurrentProcess (), & process_mask, & system_mask))
+    {
+        int count (0);
+        for (; process_mask != 0; process_mask &= process_mask - 1)
+            ++count;
+        if (count > 0)
+            result = std::min (result, static_cast<double> (count));
+    }
+    JOBOBJECT_CPU_RATE_CONTROL_INFORMATION rate {};
+    if (
+        QueryInformationJobObject (nullptr, JobObjectCpuRateControlInformation, & rate, sizeof (rate), nullptr)
+        and rate.ControlFlags bitand JOB_OBJECT_CPU_RATE_CONTROL_ENABLE
+        and rate.ControlFlags bitand JOB_OBJECT_CPU_RATE_CONTROL_HARD_CAP
+    )
+    {
+        // In 1/100 of a percent of all the processors of the system.
+        const auto processors (static_cast<double> (GetActiveProcessorCount (ALL_PROCESSOR_GROUPS)));
+        const auto value (processors * rate.CpuRate / 10000.0);
+        if (value > 0)
+            result = std::min (result, value);
+    }
+    return result;
+}
+
+} // namespace background
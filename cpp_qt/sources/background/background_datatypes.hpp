@@ -1,5 +1,7 @@
 #pragma once
 
+#include <chrono>
+
 #include <QtCore/QString>
 
 namespace background
@@ -19,14 +21,18 @@ enum struct service_state : unsigned int
     starting,
     serving,
     stopping,
-    stopped
+    stopped,
+    pausing,
+    paused,
+    resuming
 };
 
 enum struct target_service_state : unsigned int
 {
     none,
     serving,
-    stopped
+    stopped,
+    paused
 };
 
 struct serving_state
@@ -37,6 +43,7 @@ struct serving_state
     bool none () const;
     bool serving () const;
     bool stopped () const;
+    bool paused () const;
 
     // c++20 default comparisons
     //friend bool operator == (serving_state, serving_state) = default;
@@ -59,16 +66,41 @@ struct application_error
 
 struct application_system_event
 {
-    // Maybe extended with reload_configuration, pause or anything.
+    // Maybe extended with anything.
     enum action
     {
-        stop
+        stop,
+        // Apply the configuration anew while serving, without restarting the process.
+        reload,
+        // Hold the work off while keeping the resources, and take it up again.
+        pause,
+        resume,
+        // Some or all of the tasks stall on memory for longer than the threshold.
+        // Caches are to be dropped and load shed before the process is killed for it.
+        memory_pressure_some,
+        memory_pressure_full
     };
 
     action action;
     QString name;
 };
 
+// The time stalled on memory within the window that makes pressure,
+// for when some of the tasks are stalled and for when all of them are. Zero for not watching.
+struct pressure_threshold
+{
+    std::chrono::microseconds some;
+    std::chrono::microseconds full;
+    std::chrono::microseconds window;
+};
+
+// A descriptor passed by the system or a previous instance, such as a listening socket.
+struct inherited_descriptor
+{
+    QString name;
+    qintptr descriptor;
+};
+
 namespace text
 {
 
@@ -97,6 +129,11 @@ inline bool serving_state::stopped () const
     return state == service_state::stopped and target_state == target_service_state::none;
 }
 
+inline bool serving_state::paused () const
+{
+    return state == service_state::paused and target_state == target_service_state::none;
+}
+
 inline bool operator == (const serving_state value_1, const serving_state value_2)
 {
     return value_1.state == value_2.state and value_1.target_state == value_2.target_state;
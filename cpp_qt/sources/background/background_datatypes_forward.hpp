@@ -9,5 +9,8 @@ enum struct target_service_state : unsigned int;
 struct serving_state;
 struct application_error;
 struct application_system_event;
+struct pressure_threshold;
+struct inherited_descriptor;
+struct application_metrics;
 
 } // namespace background
@@ -0,0 +1,104 @@
+#include "background_deadline_guard.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+
+#include <QtCore/QThread>
+#include <QtCore/QLoggingCategory>
+
+#if not defined Q_OS_WIN
+#include <signal.h>
+#include <pthread.h>
+#endif
+
+static Q_LOGGING_CATEGORY (category, "background.application")
+
+namespace background
+{
+
+deadline_guard::deadline_guard ()
+    : thread (nullptr),
+    deadline (QDeadlineTimer::Forever),
+    exit_code (0),
+    exiting (false)
+{}
+
+deadline_guard::~deadline_guard ()
+{
+    if (thread == nullptr)
+        return;
+    {
+        QMutexLocker locker (& mutex);
+        exiting = true;
+    }
+    condition.wakeOne ();
+    thread->wait ();
+    delete thread;
+}
+
+void deadline_guard::arm (const QDeadlineTimer & deadline_, const QString & name_, const int exit_code_)
+{
+    {
+        QMutexLocker locker (& mutex);
+        deadline = deadline_;
+        name = name_;
+        exit_code = exit_code_;
+    }
+    if (thread == nullptr)
+    {
+        // Started on demand: most applications never set a deadline.
+        thread = QThread::create (& deadline_guard::run, this);
+        #if defined Q_OS_WIN
+        thread->start ();
+        #else
+        // Started before the platforms block the signals they handle, the thread would take them,
+        // and their default action would end the process. So it starts with all of them blocked.
+        sigset_t all;
+        sigset_t previous;
+        sigfillset (& all);
+        pthread_sigmask (SIG_BLOCK, & all, & previous);
+        thread->start ();
+        pthread_sigmask (SIG_SETMASK, & previous, nullptr);
+        #endif
+        return;
+    }
+    condition.wakeOne ();
+}
+
+void deadline_guard::disarm ()
+{
+    if (thread == nullptr)
+        return;
+    {
+        QMutexLocker locker (& mutex);
+        deadline = QDeadlineTimer (QDeadlineTimer::Forever);
+    }
+    condition.wakeOne ();
+}
+
+void deadline_guard::run ()
+{
+    QMutexLocker locker (& mutex);
+    while (not exiting)
+    {
+        if (not deadline.hasExpired ())
+        {
+            condition.wait (& mutex, deadline);
+            continue;
+        }
+        // Nothing is left to wait for: the state of the application is unknown, the event loop may be stuck.
+        // Whatever has not been flushed by now is lost.
+        // So is a message through a handler that writes from a thread of its own, such as 'log_writer': it goes to the standard error.
+        if (category ().isWarningEnabled ())
+        {
+            std::fprintf (
+                stderr, "%s: Failed to %s in time. Exit with the result: '%d'.\n",
+                category ().categoryName (), qUtf8Printable (name), exit_code
+            );
+            std::fflush (stderr);
+        }
+        std::_Exit (exit_code);
+    }
+}
+
+} // namespace background
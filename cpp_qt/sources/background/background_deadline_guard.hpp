@@ -0,0 +1,41 @@
+#pragma once
+
+#include <QtCore/QString>
+#include <QtCore/QMutex>
+#include <QtCore/QWaitCondition>
+#include <QtCore/QDeadlineTimer>
+
+class QThread;
+
+namespace background
+{
+
+// Exits the process once the deadline passes.
+// Waits in a thread of its own, so a handler blocking the event loop is no excuse.
+class deadline_guard
+{
+    public :
+    deadline_guard ();
+    ~deadline_guard ();
+
+    public :
+    void arm (const QDeadlineTimer & deadline, const QString & name, int exit_code);
+    void disarm ();
+
+    private :
+    void run ();
+
+    private :
+    QMutex mutex;
+    QWaitCondition condition;
+    QThread * thread;
+    QDeadlineTimer deadline;
+    QString name;
+    int exit_code;
+    bool exiting;
+
+    private :
+    Q_DISABLE_COPY (deadline_guard)
+};
+
+} // namespace background
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <vector>
+
+#include "background_datatypes.hpp"
+
+namespace background
+{
+
+// Takes over the descriptors passed with 'LISTEN_FDS', 'LISTEN_FDNAMES' and 'LISTEN_PID'
+// and removes those from the environment, so that they are not passed on to child processes.
+std::vector<inherited_descriptor> inherit_descriptors ();
+
+} // namespace background
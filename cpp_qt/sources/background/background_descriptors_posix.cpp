@@ -0,0 +1,61 @@
+#include "background_descriptors.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <QtCore/QScopeGuard>
+
+namespace background
+{
+
+namespace
+{
+
+// 'SD_LISTEN_FDS_START'.
+constexpr int first_descriptor (3);
+
+} // namespace
+
+std::vector<inherited_descriptor> inherit_descriptors ()
+{
+    const auto clean_up (qScopeGuard (
+        [] ()
+        {
+            qunsetenv ("LISTEN_PID");
+            qunsetenv ("LISTEN_FDS");
+            qunsetenv ("LISTEN_FDNAMES");
+        }
+    ));
+
+    // Intended for another process, when passed through the environment.
+    bool valid (false);
+    const auto process_id (qgetenv ("LISTEN_PID").toLongLong (& valid));
+    if (not valid or process_id != static_cast<qint64> (::getpid ()))
+        return {};
+    const auto count (qgetenv ("LISTEN_FDS").toInt (& valid));
+    if (not valid or count <= 0)
+        return {};
+    const auto names (qgetenv ("LISTEN_FDNAMES").split (':'));
+
+    std::vector<inherited_descriptor> result;
+    result.reserve (static_cast<std::size_t> (count));
+    for (int i (0); i < count; ++i)
+    {
+        const int descriptor (first_descriptor + i);
+        const auto flags (::fcntl (descriptor, F_GETFD));
+        if (flags == -1)
+            continue;
+        ::fcntl (descriptor, F_SETFD, flags bitor FD_CLOEXEC);
+        result.push_back (
+            inherited_descriptor
+            { // c++20 designated initializers
+                /*.name =*/i < names.size () and not names.at (i).isEmpty ()
+                ? QString::fromUtf8 (names.at (i)) : QStringLiteral ("unknown"),
+                /*.descriptor =*/descriptor
+            }
+        );
+    }
+    return result;
+}
+
+} // namespace background
@@ -0,0 +1,12 @@
+#include "background_descriptors.hpp"
+
+namespace background
+{
+
+// There is no such convention for the Service Control Manager.
+std::vector<inherited_descriptor> inherit_descriptors ()
+{
+    return {};
+}
+
+} // namespace background
@@ -25,6 +25,8 @@ void event_loop_controller_qt::exit (const int exit_code)
     Q_EMIT exit_ (exit_code);
 }
 
+#if not defined background_no_plugins
+
 background_event_loop_controller_plugin_qt::background_event_loop_controller_plugin_qt (QObject * const parent)
     : event_loop_controller_plugin (parent)
 {}
@@ -34,6 +36,10 @@ event_loop_controller * background_event_loop_controller_plugin_qt::create (QObj
     return new event_loop_controller_qt (parent);
 }
 
+#endif
+
 } // namespace background
 
+#if not defined background_no_plugins
 Q_IMPORT_PLUGIN (background_event_loop_controller_plugin_qt)
+#endif
@@ -1,6 +1,6 @@
 #pragma once
 
-#if not defined QT_STATICPLUGIN
+#if not defined QT_STATICPLUGIN and not defined background_no_plugins
 #define QT_STATICPLUGIN
 #endif
 
@@ -25,6 +25,8 @@ class event_loop_controller_qt : public event_loop_controller
     Q_DISABLE_COPY (event_loop_controller_qt)
 };
 
+#if not defined background_no_plugins
+
 class background_event_loop_controller_plugin_qt : public event_loop_controller_plugin
 {
     public :
@@ -40,4 +42,6 @@ class background_event_loop_controller_plugin_qt : public event_loop_controller_
     Q_INTERFACES (background::event_loop_controller_plugin)
 };
 
+#endif
+
 } // namespace background
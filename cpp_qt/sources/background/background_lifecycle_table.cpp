@@ -0,0 +1,51 @@
+#include "background_lifecycle_table.hpp"
+
+namespace background
+{
+
+namespace
+{
+
+template <class table>
+QString subgraph (const table & table_, const QString & name);
+
+} // namespace
+
+QString lifecycle_graph ()
+{
+    QString graph (QStringLiteral ("digraph lifecycle\n{\n"));
+    graph += subgraph (starting_table, QStringLiteral ("starting"));
+    graph += subgraph (stopping_table, QStringLiteral ("stopping"));
+    graph += subgraph (reloading_table, QStringLiteral ("reloading"));
+    graph += subgraph (pausing_table, QStringLiteral ("pausing"));
+    graph += QStringLiteral ("}\n");
+    return graph;
+}
+
+namespace
+{
+
+// The nodes are prefixed with the sequence, as sequences have steps of the same name.
+template <class table>
+QString subgraph (const table & table_, const QString & name)
+{
+    const auto node = [& name] (const char * const step)
+    {
+        return QStringLiteral ("\"%1.%2\"").arg (name, QString::fromUtf8 (step));
+    };
+    QString graph (QStringLiteral ("    subgraph cluster_%1\n    {\n        label=\"%1\";\n").arg (name));
+    for (std::size_t i (0); i < table_.size (); ++i)
+    {
+        const auto & transition (table_ [i]);
+        graph += QStringLiteral ("        %1 -> %2").arg (node (table_.name (transition.from)), node (table_.name (transition.to)));
+        if (* transition.condition != '\0')
+            graph += QStringLiteral (" [label=\"%1\"]").arg (QString::fromUtf8 (transition.condition));
+        graph += QStringLiteral (";\n");
+    }
+    graph += QStringLiteral ("    }\n");
+    return graph;
+}
+
+} // namespace
+
+} // namespace background
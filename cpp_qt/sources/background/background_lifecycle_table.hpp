@@ -0,0 +1,341 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include <QtCore/QString>
+
+namespace background
+{
+
+enum class starting_sequence
+{
+    none,
+    set_up_event_loop_controller,
+
+    set_up_service_platform,
+    start_service_platform,
+    retrieve_service_configuration,
+    start_serving_1,
+    set_service_state_serving,
+
+    set_up_console_platform,
+    start_console_platform,
+    start_serving_2,
+
+    start_serving_3,
+
+    set_state_serving,
+    done
+};
+
+enum class stopping_sequence
+{
+    none,
+    set_up_event_loop_controller,
+
+    set_service_state_stopping,
+    stop_serving,
+    set_service_state_stopped,
+    stop_service_platform,
+
+    stop_console_platform,
+
+    exit_application,
+    set_state_stopped,
+    done
+};
+
+// Only while serving. Stopping abandons reloading.
+enum class reloading_sequence
+{
+    none,
+    requested,
+    reload,
+    // Requested again while reloading.
+    reload_again,
+    reloaded
+};
+
+// Only while serving, paused or in between. Stopping abandons pausing or resuming.
+enum class pausing_sequence
+{
+    none,
+    pause_serving,
+    set_state_paused,
+    resume_serving,
+    set_state_serving
+};
+
+template <class sequence>
+struct lifecycle_transition
+{
+    sequence from;
+    sequence to;
+    // What the transition is taken on, for the graph.
+    const char * condition;
+};
+
+// The steps of a sequence and the transitions between them, from 'none' to 'done' or from 'none' back to it.
+// Validated when compiling, and checked on each transition when proceeding: the successors of a step are a bit mask indexed by the step.
+// The sequences are still proceeded by their switches in the application, the table is not what dispatches them.
+template <class sequence, std::size_t step_count, std::size_t transition_count>
+class lifecycle_table
+{
+    public :
+    using transition = lifecycle_transition<sequence>;
+
+    static_assert (step_count <= 32, "The successors of a step are a 32 bit mask.");
+
+    public :
+    constexpr lifecycle_table (
+        const std::array<const char *, step_count> & names,
+        const std::array<transition, transition_count> & transitions
+    )
+        : names (names),
+        transitions (transitions),
+        successors ()
+    {
+        for (const auto & transition_ : transitions)
+            successors [index (transition_.from)] |= bit (transition_.to);
+    }
+
+    public :
+    static constexpr std::size_t index (const sequence step)
+    {
+        return static_cast<std::size_t> (step);
+    }
+
+    constexpr bool allows (const sequence from, const sequence to) const
+    {
+        return (successors [index (from)] bitand bit (to)) != 0;
+    }
+
+    constexpr const char * name (const sequence step) const
+    {
+        return names [index (step)];
+    }
+
+    constexpr std::size_t steps () const
+    {
+        return step_count;
+    }
+
+    constexpr std::size_t size () const
+    {
+        return transition_count;
+    }
+
+    constexpr const transition & operator [] (const std::size_t index) const
+    {
+        return transitions [index];
+    }
+
+    // Every step is named, is reached from 'none', and reaches 'done'. Nothing leads back to 'none' or away from 'done'.
+    // A transition left out of the initializer is '{ none, none, nullptr }', and fails this too.
+    constexpr bool valid () const
+    {
+        for (const auto name_ : names)
+        {
+            if (name_ == nullptr)
+                return false;
+        }
+        if (reached (sequence::none) != all ())
+            return false;
+        for (std::size_t i (0); i < step_count; ++i)
+        {
+            if ((reached (static_cast<sequence> (i)) bitand bit (sequence::done)) == 0)
+                return false;
+            if ((successors [i] bitand bit (sequence::none)) != 0)
+                return false;
+        }
+        return successors [index (sequence::done)] == 0;
+    }
+
+    // Every step is named, is reached from 'none', and leads back to it. For the sequences that run again and again.
+    constexpr bool valid_cycle () const
+    {
+        for (const auto name_ : names)
+        {
+            if (name_ == nullptr)
+                return false;
+        }
+        if (reached (sequence::none) != all ())
+            return false;
+        for (std::size_t i (1); i < step_count; ++i)
+        {
+            if ((reached (static_cast<sequence> (i)) bitand bit (sequence::none)) == 0)
+                return false;
+        }
+        return true;
+    }
+
+    private :
+    static constexpr std::uint32_t bit (const sequence step)
+    {
+        return std::uint32_t (1) << index (step);
+    }
+
+    static constexpr std::uint32_t all ()
+    {
+        return step_count == 32 ? ~std::uint32_t (0) : (std::uint32_t (1) << step_count) - 1;
+    }
+
+    // The steps reached from a step, itself included.
+    constexpr std::uint32_t reached (const sequence from) const
+    {
+        std::uint32_t reached_ (bit (from));
+        Q_FOREVER
+        {
+            std::uint32_t next (reached_);
+            for (std::size_t i (0); i < step_count; ++i)
+            {
+                if ((reached_ >> i) bitand 1)
+                    next |= successors [i];
+            }
+            if (next == reached_)
+                return reached_;
+            reached_ = next;
+        }
+    }
+
+    private :
+    std::array<const char *, step_count> names;
+    std::array<transition, transition_count> transitions;
+    std::array<std::uint32_t, step_count> successors;
+};
+
+// Failing to start serving, to set the service state to serving or to retrieve the configuration, is an error.
+// It is not a transition of starting, as stopping takes over.
+inline constexpr lifecycle_table<starting_sequence, 13, 16> starting_table
+(
+    {
+        "none",
+        "set_up_event_loop_controller",
+        "set_up_service_platform",
+        "start_service_platform",
+        "retrieve_service_configuration",
+        "start_serving_1",
+        "set_service_state_serving",
+        "set_up_console_platform",
+        "start_console_platform",
+        "start_serving_2",
+        "start_serving_3",
+        "set_state_serving",
+        "done"
+    },
+    {{
+        { starting_sequence::none, starting_sequence::set_up_event_loop_controller, "" },
+        { starting_sequence::set_up_event_loop_controller, starting_sequence::set_up_service_platform, "as a service" },
+        { starting_sequence::set_up_event_loop_controller, starting_sequence::set_up_console_platform, "no service" },
+        { starting_sequence::set_up_event_loop_controller, starting_sequence::start_serving_3, "neither" },
+        { starting_sequence::set_up_service_platform, starting_sequence::start_service_platform, "started" },
+        { starting_sequence::set_up_service_platform, starting_sequence::set_up_console_platform, "failed" },
+        { starting_sequence::start_service_platform, starting_sequence::retrieve_service_configuration, "started" },
+        { starting_sequence::start_service_platform, starting_sequence::set_up_console_platform, "failed" },
+        { starting_sequence::retrieve_service_configuration, starting_sequence::start_serving_1, "retrieved or not" },
+        { starting_sequence::start_serving_1, starting_sequence::set_service_state_serving, "started" },
+        { starting_sequence::set_service_state_serving, starting_sequence::set_state_serving, "set" },
+        { starting_sequence::set_up_console_platform, starting_sequence::start_console_platform, "started" },
+        { starting_sequence::start_console_platform, starting_sequence::start_serving_2, "started" },
+        { starting_sequence::start_serving_2, starting_sequence::set_state_serving, "started" },
+        { starting_sequence::start_serving_3, starting_sequence::set_state_serving, "started" },
+        { starting_sequence::set_state_serving, starting_sequence::done, "" }
+    }}
+);
+
+// Stopping starts off the step starting got to.
+inline constexpr lifecycle_table<stopping_sequence, 10, 18> stopping_table
+(
+    {
+        "none",
+        "set_up_event_loop_controller",
+        "set_service_state_stopping",
+        "stop_serving",
+        "set_service_state_stopped",
+        "stop_service_platform",
+        "stop_console_platform",
+        "exit_application",
+        "set_state_stopped",
+        "done"
+    },
+    {{
+        { stopping_sequence::none, stopping_sequence::set_up_event_loop_controller, "not started" },
+        { stopping_sequence::none, stopping_sequence::set_service_state_stopping, "serving as a service, not upgraded" },
+        { stopping_sequence::none, stopping_sequence::stop_serving, "serving otherwise or failed to start serving" },
+        { stopping_sequence::none, stopping_sequence::set_service_state_stopped, "service started" },
+        { stopping_sequence::none, stopping_sequence::stop_console_platform, "console application started" },
+        { stopping_sequence::none, stopping_sequence::exit_application, "no platform started" },
+        // Another instance is running, so this one is done without starting.
+        { stopping_sequence::none, stopping_sequence::done, "another instance" },
+        { stopping_sequence::set_up_event_loop_controller, stopping_sequence::exit_application, "" },
+        { stopping_sequence::set_service_state_stopping, stopping_sequence::stop_serving, "set" },
+        { stopping_sequence::stop_serving, stopping_sequence::set_service_state_stopped, "service" },
+        { stopping_sequence::stop_serving, stopping_sequence::stop_service_platform, "upgraded service" },
+        { stopping_sequence::stop_serving, stopping_sequence::stop_console_platform, "console application" },
+        { stopping_sequence::stop_serving, stopping_sequence::exit_application, "neither" },
+        { stopping_sequence::set_service_state_stopped, stopping_sequence::stop_service_platform, "set" },
+        { stopping_sequence::stop_service_platform, stopping_sequence::exit_application, "stopped" },
+        { stopping_sequence::stop_console_platform, stopping_sequence::exit_application, "stopped" },
+        { stopping_sequence::exit_application, stopping_sequence::set_state_stopped, "" },
+        { stopping_sequence::set_state_stopped, stopping_sequence::done, "" }
+    }}
+);
+
+// Set on a reload request from the system, and by the application once reloaded.
+inline constexpr lifecycle_table<reloading_sequence, 5, 9> reloading_table
+(
+    {
+        "none",
+        "requested",
+        "reload",
+        "reload_again",
+        "reloaded"
+    },
+    {{
+        { reloading_sequence::none, reloading_sequence::requested, "requested" },
+        { reloading_sequence::requested, reloading_sequence::requested, "requested" },
+        { reloading_sequence::requested, reloading_sequence::reload, "" },
+        { reloading_sequence::reload, reloading_sequence::reload_again, "requested" },
+        { reloading_sequence::reload, reloading_sequence::reloaded, "reloaded or no handler" },
+        { reloading_sequence::reload_again, reloading_sequence::reload_again, "requested" },
+        { reloading_sequence::reload_again, reloading_sequence::requested, "reloaded" },
+        { reloading_sequence::reloaded, reloading_sequence::requested, "requested" },
+        { reloading_sequence::reloaded, reloading_sequence::none, "" }
+    }}
+);
+
+// Pausing and resuming take turns, each from 'none' back to it.
+inline constexpr lifecycle_table<pausing_sequence, 5, 6> pausing_table
+(
+    {
+        "none",
+        "pause_serving",
+        "set_state_paused",
+        "resume_serving",
+        "set_state_serving"
+    },
+    {{
+        { pausing_sequence::none, pausing_sequence::pause_serving, "pause while serving" },
+        { pausing_sequence::pause_serving, pausing_sequence::set_state_paused, "paused or no handler" },
+        { pausing_sequence::set_state_paused, pausing_sequence::none, "" },
+        { pausing_sequence::none, pausing_sequence::resume_serving, "resume while paused" },
+        { pausing_sequence::resume_serving, pausing_sequence::set_state_serving, "resumed or no handler" },
+        { pausing_sequence::set_state_serving, pausing_sequence::none, "" }
+    }}
+);
+
+static_assert (starting_table.steps () == static_cast<std::size_t> (starting_sequence::done) + 1, "Every starting step has a name.");
+static_assert (stopping_table.steps () == static_cast<std::size_t> (stopping_sequence::done) + 1, "Every stopping step has a name.");
+static_assert (reloading_table.steps () == static_cast<std::size_t> (reloading_sequence::reloaded) + 1, "Every reloading step has a name.");
+static_assert (pausing_table.steps () == static_cast<std::size_t> (pausing_sequence::set_state_serving) + 1, "Every pausing step has a name.");
+static_assert (starting_table.valid (), "Every starting step is reached from 'none' and reaches 'done'.");
+static_assert (stopping_table.valid (), "Every stopping step is reached from 'none' and reaches 'done'.");
+static_assert (reloading_table.valid_cycle (), "Every reloading step is reached from 'none' and leads back to it.");
+static_assert (pausing_table.valid_cycle (), "Every pausing step is reached from 'none' and leads back to it.");
+
+// The tables in the DOT format of Graphviz.
+QString lifecycle_graph ();
+
+} // namespace background
@@ -0,0 +1,147 @@
+#include "background_lifecycle_trace.hpp"
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QJsonObject>
+#include <QtCore/QJsonArray>
+#include <QtCore/QSaveFile>
+
+namespace background
+{
+
+namespace
+{
+
+QString track_name (lifecycle_trace::track track);
+
+} // namespace
+
+lifecycle_trace::lifecycle_trace ()
+{}
+
+void lifecycle_trace::begin (const track track, const QString & name)
+{
+    spans [name] = span
+    { // c++20 designated initializers
+        /*.track_ =*/track,
+        /*.time =*/now ()
+    };
+}
+
+void lifecycle_trace::end (const QString & name)
+{
+    const auto found (spans.find (name));
+    if (found == spans.end ())
+        return;
+    events.push_back (
+        event
+        { // c++20 designated initializers
+            /*.track_ =*/found->second.track_,
+            /*.name =*/name,
+            /*.time =*/found->second.time,
+            /*.duration =*/now () - found->second.time
+        }
+    );
+    spans.erase (found);
+}
+
+void lifecycle_trace::instant (const track track, const QString & name)
+{
+    events.push_back (
+        event
+        { // c++20 designated initializers
+            /*.track_ =*/track,
+            /*.name =*/name,
+            /*.time =*/now (),
+            /*.duration =*/std::chrono::microseconds (-1)
+        }
+    );
+}
+
+// https://docs.google.com/document/d/1CvAClvFfyA5R-PhYUmn5OOQtYMH4h6I0nSsKchNAySU
+QByteArray lifecycle_trace::to_json () const
+{
+    const auto process_id (QCoreApplication::applicationPid ());
+    QJsonArray result;
+    for (const auto track : { sequence, handler, platform })
+    {
+        result.append (
+            QJsonObject
+            {
+                { QStringLiteral ("name"), QStringLiteral ("thread_name") },
+                { QStringLiteral ("ph"), QStringLiteral ("M") },
+                { QStringLiteral ("pid"), process_id },
+                { QStringLiteral ("tid"), static_cast<int> (track) },
+                { QStringLiteral ("args"), QJsonObject { { QStringLiteral ("name"), track_name (track) } } }
+            }
+        );
+    }
+    // The spans still open are cut at the time of exporting.
+    auto events_ (events);
+    const auto time (now ());
+    for (const auto & [ name, span ] : spans)
+        events_.push_back ({ span.track_, name, span.time, time - span.time });
+    for (const auto & event : events_)
+    {
+        QJsonObject value
+        {
+            { QStringLiteral ("name"), event.name },
+            { QStringLiteral ("cat"), QStringLiteral ("background") },
+            { QStringLiteral ("pid"), process_id },
+            { QStringLiteral ("tid"), static_cast<int> (event.track_) },
+            { QStringLiteral ("ts"), static_cast<qint64> (event.time.count ()) }
+        };
+        if (event.duration.count () < 0)
+        {
+            value.insert (QStringLiteral ("ph"), QStringLiteral ("i"));
+            value.insert (QStringLiteral ("s"), QStringLiteral ("t"));
+        }
+        else
+        {
+            value.insert (QStringLiteral ("ph"), QStringLiteral ("X"));
+            value.insert (QStringLiteral ("dur"), static_cast<qint64> (event.duration.count ()));
+        }
+        result.append (value);
+    }
+    return QJsonDocument (
+        QJsonObject
+        {
+            { QStringLiteral ("traceEvents"), result },
+            { QStringLiteral ("displayTimeUnit"), QStringLiteral ("ms") }
+        }
+    ).toJson (QJsonDocument::Compact);
+}
+
+bool lifecycle_trace::write (const QString & path) const
+{
+    QSaveFile file (path);
+    if (not file.open (QIODevice::WriteOnly))
+        return false;
+    if (file.write (to_json ()) == -1)
+        return false;
+    return file.commit ();
+}
+
+// The same clock in every process, so that the traces of the instances line up.
+std::chrono::microseconds lifecycle_trace::now ()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds> (std::chrono::steady_clock::now ().time_since_epoch ());
+}
+
+namespace
+{
+
+QString track_name (const lifecycle_trace::track track)
+{
+    switch (track)
+    {
+        case lifecycle_trace::sequence : return QStringLiteral ("lifecycle");
+        case lifecycle_trace::handler : return QStringLiteral ("handlers");
+        case lifecycle_trace::platform : return QStringLiteral ("platform");
+        default : Q_UNREACHABLE (); return {};
+    }
+}
+
+} // namespace
+
+} // namespace background
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <chrono>
+#include <vector>
+#include <map>
+
+#include <QtCore/QString>
+#include <QtCore/QByteArray>
+
+namespace background
+{
+
+// Spans and instants of the lifecycle on a monotonic clock,
+// exported in the trace event format of Chrome to be loaded in Perfetto.
+// Spans are matched by name, so that the ones of different tracks may overlap.
+class lifecycle_trace
+{
+    public :
+    enum track
+    {
+        sequence = 1,
+        handler,
+        platform
+    };
+
+    public :
+    lifecycle_trace ();
+
+    public :
+    void begin (track track, const QString & name);
+    void end (const QString & name);
+    void instant (track track, const QString & name);
+
+    QByteArray to_json () const;
+    bool write (const QString & path) const;
+
+    private :
+    struct event
+    {
+        track track_;
+        QString name;
+        std::chrono::microseconds time;
+        // Negative for an instant.
+        std::chrono::microseconds duration;
+    };
+
+    struct span
+    {
+        track track_;
+        std::chrono::microseconds time;
+    };
+
+    static std::chrono::microseconds now ();
+
+    private :
+    std::vector<event> events;
+    std::map<QString, span> spans;
+};
+
+} // namespace background
@@ -0,0 +1,477 @@
+#include "background_log_writer.hpp"
+
+#include <array>
+#include <algorithm>
+#include <chrono>
+#include <cerrno>
+#include <cassert>
+
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QDir>
+#include <QtCore/QThread>
+#include <QtCore/QDeadlineTimer>
+
+#if not defined Q_OS_WIN
+#include <sys/uio.h>
+#endif
+
+namespace background
+{
+
+namespace
+{
+
+// Two buffers a line, the line and its break, well within 'IOV_MAX'.
+constexpr std::size_t batch_size (256);
+// The writer checks on the ring at least this often, should a wake be missed.
+constexpr std::chrono::milliseconds idle_interval (100);
+// Written to directly: the batches are the buffering.
+const QIODevice::OpenMode open_mode (QIODevice::WriteOnly bitor QIODevice::Append bitor QIODevice::Unbuffered);
+
+std::atomic<log_writer *> instance (nullptr);
+QtMessageHandler previous_handler (nullptr);
+
+std::size_t round_up_to_power_of_two (std::size_t value);
+QString generation_path (const QString & path, int generation);
+void shift_generations (const QString & path, int generations);
+
+void process_message (QtMsgType type, const QMessageLogContext & context, const QString & message);
+
+} // namespace
+
+log_writer::log_writer (const std::size_t capacity, const overflow_policy policy)
+    : policy (policy),
+    mask (round_up_to_power_of_two (std::max (capacity, std::size_t (2))) - 1),
+    ring (new slot [mask + 1]),
+    head (0),
+    tail (0),
+    written (0),
+    waiting (0),
+    dropped_ (0),
+    reported (0),
+    running (false),
+    sleeping (false),
+    available (0),
+    rotation_size_ (0),
+    rotation_interval_ (0),
+    rotation_generations_ (1),
+    rotation_requested (false),
+    file_size (0),
+    file (nullptr),
+    thread (nullptr)
+{
+    for (std::size_t i (0); i <= mask; ++i)
+        ring [i].sequence.store (i, std::memory_order_relaxed);
+}
+
+log_writer::~log_writer ()
+{
+    uninstall_message_handler ();
+    close ();
+}
+
+bool log_writer::open (const QString & path)
+{
+    if (thread != nullptr)
+        return false;
+    file = new QFile (path);
+    if (not file->open (open_mode))
+    {
+        delete file;
+        file = nullptr;
+        return false;
+    }
+    file_size = file->size ();
+    opened = std::chrono::steady_clock::now ();
+    running.store (true, std::memory_order_release);
+    thread = QThread::create ([this] () { run (); });
+    thread->setObjectName (QStringLiteral ("log_writer"));
+    thread->start ();
+    return true;
+}
+
+void log_writer::close ()
+{
+    if (thread != nullptr)
+    {
+        running.store (false, std::memory_order_release);
+        available.release ();
+        thread->wait ();
+        delete thread;
+        thread = nullptr;
+        notify_progress ();
+    }
+    if (file != nullptr)
+    {
+        file->close ();
+        delete file;
+        file = nullptr;
+    }
+}
+
+bool log_writer::is_open () const
+{
+    return thread != nullptr;
+}
+
+bool log_writer::write (QByteArray line)
+{
+    Q_FOREVER
+    {
+        // Before trying, so that a batch written meanwhile is not waited for.
+        const auto seen (written.load (std::memory_order_seq_cst));
+        if (push (line))
+        {
+            wake ();
+            return true;
+        }
+        if (policy == overflow_policy::block and running.load (std::memory_order_acquire))
+        {
+            wake ();
+            wait_for_progress (seen);
+            continue;
+        }
+        dropped_.fetch_add (1, std::memory_order_relaxed);
+        return false;
+    }
+}
+
+void log_writer::flush ()
+{
+    const auto pushed (head.load (std::memory_order_acquire));
+    wake ();
+    Q_FOREVER
+    {
+        const auto seen (written.load (std::memory_order_seq_cst));
+        if (seen >= pushed or not running.load (std::memory_order_acquire))
+            return;
+        wait_for_progress (seen);
+    }
+}
+
+std::uint64_t log_writer::dropped () const
+{
+    return dropped_.load (std::memory_order_relaxed);
+}
+
+qint64 log_writer::rotation_size () const
+{
+    return rotation_size_;
+}
+
+log_writer & log_writer::set_rotation_size (const qint64 size)
+{
+    assert (not is_open ());
+    rotation_size_ = size;
+    return * this;
+}
+
+std::chrono::milliseconds log_writer::rotation_interval () const
+{
+    return rotation_interval_;
+}
+
+log_writer & log_writer::set_rotation_interval (const std::chrono::milliseconds interval)
+{
+    assert (not is_open ());
+    rotation_interval_ = interval;
+    return * this;
+}
+
+int log_writer::rotation_generations () const
+{
+    return rotation_generations_;
+}
+
+log_writer & log_writer::set_rotation_generations (const int generations)
+{
+    assert (not is_open ());
+    rotation_generations_ = std::max (generations, 0);
+    return * this;
+}
+
+void log_writer::rotate ()
+{
+    rotation_requested.store (true, std::memory_order_release);
+    wake ();
+}
+
+void log_writer::install_message_handler ()
+{
+    log_writer * expected (nullptr);
+    if (not instance.compare_exchange_strong (expected, this, std::memory_order_acq_rel))
+        return;
+    previous_handler = qInstallMessageHandler (& process_message);
+}
+
+void log_writer::uninstall_message_handler ()
+{
+    log_writer * expected (this);
+    if (not instance.compare_exchange_strong (expected, nullptr, std::memory_order_acq_rel))
+        return;
+    qInstallMessageHandler (previous_handler);
+}
+
+// A bounded queue of many producers, with a sequence number a slot.
+// A slot is free to push into at position 'p' where its sequence is 'p', and holds a line to pop where it is 'p + 1'.
+bool log_writer::push (QByteArray & line)
+{
+    auto position (head.load (std::memory_order_relaxed));
+    Q_FOREVER
+    {
+        auto & slot_ (ring [position bitand mask]);
+        const auto sequence (slot_.sequence.load (std::memory_order_acquire));
+        const auto difference (static_cast<std::ptrdiff_t> (sequence - position));
+        if (difference == 0)
+        {
+            if (head.compare_exchange_weak (position, position + 1, std::memory_order_relaxed))
+            {
+                slot_.line = std::move (line);
+                slot_.sequence.store (position + 1, std::memory_order_release);
+                return true;
+            }
+        }
+        // Full: the slot still holds the line of the previous lap.
+        else if (difference < 0)
+            return false;
+        else
+            position = head.load (std::memory_order_relaxed);
+    }
+}
+
+std::size_t log_writer::pop (QByteArray * const lines, const std::size_t count)
+{
+    std::size_t i (0);
+    for (; i < count; ++i)
+    {
+        auto & slot_ (ring [tail bitand mask]);
+        if (slot_.sequence.load (std::memory_order_acquire) != tail + 1)
+            break;
+        lines [i] = std::move (slot_.line);
+        slot_.sequence.store (tail + mask + 1, std::memory_order_release);
+        ++tail;
+    }
+    return i;
+}
+
+// Only a thread that finds the writer sleeping wakes it, so a steady stream of lines takes no system call to hand over.
+void log_writer::wake ()
+{
+    std::atomic_thread_fence (std::memory_order_seq_cst);
+    if (sleeping.load (std::memory_order_relaxed) and sleeping.exchange (false, std::memory_order_relaxed))
+        available.release ();
+}
+
+void log_writer::run ()
+{
+    std::array<QByteArray, batch_size> lines;
+    Q_FOREVER
+    {
+        // Stopped, the ring is drained once more.
+        const auto running_ (running.load (std::memory_order_acquire));
+        rotate_if_due ();
+        const auto count (pop (lines.data (), lines.size ()));
+        if (count != 0)
+        {
+            write_batch (lines.data (), count);
+            report_dropped ();
+            // Rotated before counted as written, so that the lines flushed are where they end up.
+            rotate_if_due ();
+            written.fetch_add (count, std::memory_order_seq_cst);
+            notify_progress ();
+            continue;
+        }
+        if (not running_)
+            break;
+        sleeping.store (true, std::memory_order_relaxed);
+        std::atomic_thread_fence (std::memory_order_seq_cst);
+        if (ring [tail bitand mask].sequence.load (std::memory_order_acquire) == tail + 1)
+        {
+            sleeping.store (false, std::memory_order_relaxed);
+            continue;
+        }
+        available.tryAcquire (1, static_cast<int> (idle_interval.count ()));
+        sleeping.store (false, std::memory_order_relaxed);
+    }
+}
+
+// Sleeps until the writer wrote past what was seen, or stopped.
+// Counted as waiting before checking, and the writer checks for waiting after counting what it wrote, so no batch is missed.
+void log_writer::wait_for_progress (const std::size_t seen)
+{
+    waiting.fetch_add (1, std::memory_order_seq_cst);
+    {
+        QMutexLocker locker (& progress_mutex);
+        while (written.load (std::memory_order_seq_cst) == seen and running.load (std::memory_order_acquire))
+            progressed.wait (& progress_mutex, QDeadlineTimer (idle_interval));
+    }
+    waiting.fetch_sub (1, std::memory_order_relaxed);
+}
+
+// Only takes the lock where some thread waits.
+void log_writer::notify_progress ()
+{
+    if (waiting.load (std::memory_order_seq_cst) == 0)
+        return;
+    QMutexLocker locker (& progress_mutex);
+    progressed.wakeAll ();
+}
+
+void log_writer::report_dropped ()
+{
+    if (policy != overflow_policy::drop_and_report)
+        return;
+    const auto dropped__ (dropped_.load (std::memory_order_relaxed));
+    if (dropped__ == reported)
+        return;
+    QByteArray line (QByteArrayLiteral ("Dropped log lines: ") + QByteArray::number (static_cast<qulonglong> (dropped__ - reported)) + '.');
+    write_batch (& line, 1);
+    reported = dropped__;
+}
+
+// Checked once a batch and once an idle interval, so the interval is kept to about that.
+void log_writer::rotate_if_due ()
+{
+    const auto now (std::chrono::steady_clock::now ());
+    const auto due (
+        rotation_requested.exchange (false, std::memory_order_acq_rel)
+        or (rotation_size_ > 0 and file_size >= rotation_size_)
+        or (rotation_interval_ > std::chrono::milliseconds::zero () and now - opened >= rotation_interval_)
+    );
+    if (not due)
+        return;
+    opened = now;
+    if (file_size == 0)
+        return;
+    rotate_file ();
+}
+
+// The file open is renamed, and the new file is opened before the old one is closed.
+// Should the new file fail to open, the writer keeps on writing to the old one, trying again once due.
+void log_writer::rotate_file ()
+{
+    const auto path (file->fileName ());
+    #if defined Q_OS_WIN
+    // An open file cannot be renamed.
+    file->close ();
+    #endif
+    shift_generations (path, rotation_generations_);
+    auto * const next (new QFile (path));
+    if (not next->open (open_mode))
+    {
+        delete next;
+        #if defined Q_OS_WIN
+        file->open (open_mode);
+        #endif
+        file_size = 0;
+        return;
+    }
+    file->close ();
+    delete file;
+    file = next;
+    file_size = 0;
+}
+
+bool log_writer::write_batch (QByteArray * const lines, const std::size_t count)
+{
+    bool result (true);
+    #if defined Q_OS_WIN
+    QByteArray batch;
+    for (std::size_t i (0); i < count; ++i)
+        batch.append (lines [i]).append ('\n');
+    result = file->write (batch) == batch.size ();
+    file_size += batch.size ();
+    #else
+    static const char line_break ('\n');
+    std::array<iovec, batch_size * 2> buffers;
+    for (std::size_t i (0); i < count; ++i)
+    {
+        buffers [i * 2] = { const_cast<char *> (lines [i].constData ()), static_cast<std::size_t> (lines [i].size ()) };
+        buffers [i * 2 + 1] = { const_cast<char *> (& line_break), 1 };
+        file_size += lines [i].size () + 1;
+    }
+    const auto descriptor (file->handle ());
+    auto * buffer (buffers.data ());
+    auto left (static_cast<int> (count * 2));
+    while (left > 0)
+    {
+        const auto size (::writev (descriptor, buffer, left));
+        if (size == -1)
+        {
+            if (errno == EINTR)
+                continue;
+            result = false;
+            break;
+        }
+        // Written in part, the rest is written from where it stopped.
+        auto size_ (static_cast<std::size_t> (size));
+        while (left > 0 and size_ >= buffer->iov_len)
+        {
+            size_ -= buffer->iov_len;
+            ++buffer;
+            --left;
+        }
+        if (left > 0)
+        {
+            buffer->iov_base = static_cast<char *> (buffer->iov_base) + size_;
+            buffer->iov_len -= size_;
+        }
+    }
+    #endif
+    // Deallocated here rather than by the logging threads.
+    for (std::size_t i (0); i < count; ++i)
+        lines [i] = QByteArray ();
+    return result;
+}
+
+namespace
+{
+
+std::size_t round_up_to_power_of_two (const std::size_t value)
+{
+    std::size_t result (1);
+    while (result < value)
+        result <<= 1;
+    return result;
+}
+
+// 'service.log.txt' as 'service.log.1.txt', 'service' as 'service.1'.
+QString generation_path (const QString & path, const int generation)
+{
+    const QFileInfo file (path);
+    const auto suffix (file.suffix ());
+    if (suffix.isEmpty ())
+        return QStringLiteral ("%1.%2").arg (path).arg (generation);
+    return QDir (file.path ()).filePath (QStringLiteral ("%1.%2.%3").arg (file.completeBaseName ()).arg (generation).arg (suffix));
+}
+
+void shift_generations (const QString & path, const int generations)
+{
+    if (generations == 0)
+    {
+        QFile::remove (path);
+        return;
+    }
+    QFile::remove (generation_path (path, generations));
+    for (auto generation (generations - 1); generation >= 1; --generation)
+        QFile::rename (generation_path (path, generation), generation_path (path, generation + 1));
+    QFile::rename (path, generation_path (path, 1));
+}
+
+void process_message (const QtMsgType type, const QMessageLogContext & context, const QString & message)
+{
+    if (previous_handler != nullptr)
+        previous_handler (type, context, message);
+    auto * const writer (instance.load (std::memory_order_acquire));
+    if (writer == nullptr)
+        return;
+    const auto line (qFormatLogMessage (type, context, message));
+    if (line.isNull ())
+        return;
+    writer->write (line.toUtf8 ());
+}
+
+} // namespace
+
+} // namespace background
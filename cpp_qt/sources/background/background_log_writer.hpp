@@ -0,0 +1,129 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include <QtCore/QByteArray>
+#include <QtCore/QString>
+#include <QtCore/QSemaphore>
+#include <QtCore/QMutex>
+#include <QtCore/QWaitCondition>
+
+#include "background_library.hpp"
+
+class QFile;
+class QThread;
+
+namespace background
+{
+
+// Writes log lines to a file from a thread of its own.
+// The logging threads format a line by themselves and hand it over through a lock-free ring of a fixed capacity.
+// The writer drains the ring in batches, writing each batch with a single system call.
+// Lines written before the file is open wait in the ring.
+// Rotating, the writer opens the new file before closing the old one, so the logging threads never wait on it.
+class background_library log_writer
+{
+    public :
+    // What a logging thread does with a line while the ring is full.
+    enum class overflow_policy
+    {
+        // Sleeps until the writer makes room. Drops once the writer is not running.
+        block,
+        drop,
+        // Drops, and the writer writes how many lines were dropped once there is room again.
+        drop_and_report
+    };
+
+    public :
+    explicit log_writer (std::size_t capacity = 4096, overflow_policy policy = overflow_policy::drop_and_report);
+    // Writes what is in the ring, if open.
+    ~log_writer ();
+
+    public :
+    // Appends to the file and starts the writer.
+    bool open (const QString & path);
+    // Writes what is in the ring, stops the writer and closes the file.
+    void close ();
+    bool is_open () const;
+
+    // From any thread, without a line break. False if dropped.
+    bool write (QByteArray line);
+    // Waits until the lines written so far are in the file. Such as for 'application::add_exit_flush ()'.
+    void flush ();
+
+    std::uint64_t dropped () const;
+
+    // Rotation, set before opening. The file is renamed with the generation before its suffix, 1 the latest,
+    // such as 'service.log.1.txt', and a new file is opened in its place. 0 not to rotate by size or time.
+    qint64 rotation_size () const;
+    log_writer & set_rotation_size (qint64 size);
+    std::chrono::milliseconds rotation_interval () const;
+    log_writer & set_rotation_interval (std::chrono::milliseconds interval);
+    // The renamed files kept, the oldest removed. 0 to remove the file rotated.
+    int rotation_generations () const;
+    log_writer & set_rotation_generations (int generations);
+    // From any thread. The writer rotates before the next batch, unless the file is empty.
+    void rotate ();
+
+    // Formats the messages of Qt with 'qFormatLogMessage ()' and writes them here, in addition to the handler installed before.
+    // A single writer at a time.
+    void install_message_handler ();
+    void uninstall_message_handler ();
+
+    private :
+    struct slot
+    {
+        std::atomic<std::size_t> sequence;
+        QByteArray line;
+    };
+
+    bool push (QByteArray & line);
+    std::size_t pop (QByteArray * lines, std::size_t count);
+    void wake ();
+    void wait_for_progress (std::size_t seen);
+    void notify_progress ();
+    void run ();
+    void report_dropped ();
+    void rotate_if_due ();
+    void rotate_file ();
+    bool write_batch (QByteArray * lines, std::size_t count);
+
+    private :
+    const overflow_policy policy;
+    const std::size_t mask;
+    const std::unique_ptr<slot []> ring;
+    // Pushed to by any thread, popped from by the writer only. Apart, so that they do not share a cache line.
+    alignas (64) std::atomic<std::size_t> head;
+    alignas (64) std::size_t tail;
+    std::atomic<std::size_t> written;
+    // The logging threads blocked on a full ring, and those flushing.
+    std::atomic<int> waiting;
+    std::atomic<std::uint64_t> dropped_;
+    std::uint64_t reported;
+    std::atomic<bool> running;
+    std::atomic<bool> sleeping;
+    // Released to wake the writer.
+    QSemaphore available;
+    // Woken once a batch is written, where some thread waits.
+    QMutex progress_mutex;
+    QWaitCondition progressed;
+    qint64 rotation_size_;
+    std::chrono::milliseconds rotation_interval_;
+    int rotation_generations_;
+    std::atomic<bool> rotation_requested;
+    // Of the file open, on the writer.
+    qint64 file_size;
+    std::chrono::steady_clock::time_point opened;
+    QFile * file;
+    QThread * thread;
+
+    private :
+    log_writer (const log_writer &) = delete;
+    log_writer & operator = (const log_writer &) = delete;
+};
+
+} // namespace background
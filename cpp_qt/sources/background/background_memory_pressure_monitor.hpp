@@ -0,0 +1,37 @@
+#pragma once
+
+#include <QtCore/QObject>
+
+#include "background_datatypes.hpp"
+
+class QSocketNotifier;
+
+namespace background
+{
+
+// Watches the memory pressure of the process through the event loop.
+// Only where the system reports stalls on memory, such as Linux with 'PSI'.
+class memory_pressure_monitor : public QObject
+{
+    public :
+    explicit memory_pressure_monitor (QObject * parent);
+    ~memory_pressure_monitor ();
+
+    public :
+    bool start (const pressure_threshold & threshold);
+    void stop ();
+
+    Q_SIGNALS :
+    void crossed (bool full);
+
+    private :
+    // Some and full.
+    int descriptors [2];
+    QSocketNotifier * notifiers [2];
+
+    private :
+    Q_OBJECT
+    Q_DISABLE_COPY (memory_pressure_monitor)
+};
+
+} // namespace background
@@ -0,0 +1,124 @@
+#include "background_memory_pressure_monitor.hpp"
+
+#include <cerrno>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <QtCore/QFile>
+#include <QtCore/QSocketNotifier>
+
+namespace background
+{
+
+namespace
+{
+
+QByteArray pressure_path ();
+
+} // namespace
+
+memory_pressure_monitor::memory_pressure_monitor (QObject * const parent)
+    : QObject (parent),
+    descriptors { -1, -1 },
+    notifiers { nullptr, nullptr }
+{}
+
+memory_pressure_monitor::~memory_pressure_monitor ()
+{
+    stop ();
+}
+
+bool memory_pressure_monitor::start (const pressure_threshold & threshold)
+{
+    const auto path (pressure_path ());
+    if (path.isEmpty ())
+    {
+        errno = ENOENT;
+        return false;
+    }
+    const std::chrono::microseconds stalls [2] { threshold.some, threshold.full };
+    for (int level (0); level < 2; ++level)
+    {
+        if (stalls [level] <= std::chrono::microseconds::zero ())
+            continue;
+        // A trigger lives as long as the descriptor it is written to. One per descriptor.
+        // Unprivileged processes are only allowed windows in multiples of 2 s.
+        const auto descriptor (::open (path.constData (), O_RDWR bitor O_NONBLOCK bitor O_CLOEXEC));
+        if (descriptor == -1)
+        {
+            stop ();
+            return false;
+        }
+        descriptors [level] = descriptor;
+        const auto trigger (
+            QByteArray (level == 0 ? "some " : "full ")
+            .append (QByteArray::number (static_cast<qint64> (stalls [level].count ())))
+            .append (' ')
+            .append (QByteArray::number (static_cast<qint64> (threshold.window.count ())))
+        );
+        // Including the terminating zero.
+        if (::write (descriptor, trigger.constData (), static_cast<std::size_t> (trigger.size ()) + 1) == -1)
+        {
+            stop ();
+            return false;
+        }
+        // The events come as 'POLLPRI', at most once per window.
+        notifiers [level] = new QSocketNotifier (descriptor, QSocketNotifier::Exception, this);
+        const bool full (level == 1);
+        connect (
+            notifiers [level], & QSocketNotifier::activated,
+            this, [this, full] () { Q_EMIT crossed (full); }
+        );
+    }
+    return true;
+}
+
+void memory_pressure_monitor::stop ()
+{
+    for (int level (0); level < 2; ++level)
+    {
+        delete notifiers [level];
+        notifiers [level] = nullptr;
+        if (descriptors [level] == -1)
+            continue;
+        ::close (descriptors [level]);
+        descriptors [level] = -1;
+    }
+}
+
+namespace
+{
+
+QByteArray pressure_path ()
+{
+    // The service manager points at the file to watch, or at '/dev/null' when the pressure is not to be watched.
+    if (qEnvironmentVariableIsSet ("MEMORY_PRESSURE_WATCH"))
+    {
+        const auto path (qgetenv ("MEMORY_PRESSURE_WATCH"));
+        if (path == "/dev/null")
+            return {};
+        return path;
+    }
+    // The pressure of the control group is the one of interest in a container or a service.
+    QFile groups (QStringLiteral ("/proc/self/cgroup"));
+    if (groups.open (QIODevice::ReadOnly bitor QIODevice::Text))
+    {
+        while (not groups.atEnd ())
+        {
+            const auto line (groups.readLine ().trimmed ());
+            if (not line.startsWith ("0::"))
+                continue;
+            const auto path (QByteArrayLiteral ("/sys/fs/cgroup").append (line.mid (3)).append ("/memory.pressure"));
+            if (::access (path.constData (), R_OK bitor W_OK) == 0)
+                return path;
+            break;
+        }
+    }
+    // The system wide one.
+    return QByteArrayLiteral ("/proc/pressure/memory");
+}
+
+} // namespace
+
+} // namespace background
@@ -0,0 +1,30 @@
+#include "background_memory_pressure_monitor.hpp"
+
+#include <QtCore/qt_windows.h>
+
+namespace background
+{
+
+// The low memory resource notification stays signaled for as long as the memory is low.
+// Not of much use through the event loop, so the pressure is not watched.
+
+memory_pressure_monitor::memory_pressure_monitor (QObject * const parent)
+    : QObject (parent),
+    descriptors { -1, -1 },
+    notifiers { nullptr, nullptr }
+{}
+
+memory_pressure_monitor::~memory_pressure_monitor ()
+{}
+
+bool memory_pressure_monitor::start (const pressure_threshold & threshold)
+{
+    Q_UNUSED (threshold)
+    SetLastError (ERROR_NOT_SUPPORTED);
+    return false;
+}
+
+void memory_pressure_monitor::stop ()
+{}
+
+} // namespace background
@@ -0,0 +1,90 @@
+#include "background_metrics.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace background
+{
+
+// Relaxed throughout: every value is consistent by itself, and the values are not meant to be read as a snapshot.
+
+latency_histogram::latency_histogram ()
+    : count_ (0),
+    sum_ (0),
+    max_ (0)
+{
+    for (auto & bucket : buckets)
+        bucket.store (0, std::memory_order_relaxed);
+}
+
+void latency_histogram::record (const std::chrono::microseconds value)
+{
+    const auto value_ (static_cast<std::uint64_t> (std::max (value.count (), std::chrono::microseconds::rep (0))));
+    std::size_t index (0);
+    while (index < bucket_count - 1 and (std::uint64_t (1) << index) < value_)
+        ++index;
+    buckets [index].fetch_add (1, std::memory_order_relaxed);
+    count_.fetch_add (1, std::memory_order_relaxed);
+    sum_.fetch_add (value_, std::memory_order_relaxed);
+    // A single writer.
+    if (value_ > max_.load (std::memory_order_relaxed))
+        max_.store (value_, std::memory_order_relaxed);
+}
+
+std::uint64_t latency_histogram::count () const
+{
+    return count_.load (std::memory_order_relaxed);
+}
+
+std::chrono::microseconds latency_histogram::sum () const
+{
+    return std::chrono::microseconds (sum_.load (std::memory_order_relaxed));
+}
+
+std::chrono::microseconds latency_histogram::max () const
+{
+    return std::chrono::microseconds (max_.load (std::memory_order_relaxed));
+}
+
+std::uint64_t latency_histogram::bucket (const std::size_t index) const
+{
+    if (index >= bucket_count)
+        return 0;
+    return buckets [index].load (std::memory_order_relaxed);
+}
+
+std::chrono::microseconds latency_histogram::quantile (const double fraction) const
+{
+    std::array<std::uint64_t, bucket_count> buckets_;
+    std::uint64_t count (0);
+    for (std::size_t i (0); i < bucket_count; ++i)
+    {
+        buckets_ [i] = buckets [i].load (std::memory_order_relaxed);
+        count += buckets_ [i];
+    }
+    if (count == 0)
+        return std::chrono::microseconds::zero ();
+    const auto rank (static_cast<std::uint64_t> (std::ceil (std::clamp (fraction, 0.0, 1.0) * static_cast<double> (count))));
+    std::uint64_t seen (0);
+    for (std::size_t i (0); i < bucket_count - 1; ++i)
+    {
+        seen += buckets_ [i];
+        if (seen >= rank and seen != 0)
+            return std::chrono::microseconds (std::int64_t (1) << i);
+    }
+    return max ();
+}
+
+application_metrics::application_metrics ()
+    : proceed_iterations (0),
+    proceed_posted (0),
+    proceed_coalesced (0),
+    control_regained (0),
+    control_retaken (0),
+    system_events (0),
+    system_events_high_water_mark (0),
+    system_events_coalesced (0),
+    system_events_dropped (0)
+{}
+
+} // namespace background
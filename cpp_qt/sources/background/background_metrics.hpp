@@ -0,0 +1,75 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#include "background_library.hpp"
+#include "background_datatypes.hpp"
+
+namespace background
+{
+
+// Durations in buckets of powers of two microseconds, the last one taking everything longer.
+// Recorded from a single thread, and read without locks from any thread.
+class background_library latency_histogram
+{
+    public :
+    static constexpr std::size_t bucket_count = 32;
+
+    public :
+    latency_histogram ();
+
+    public :
+    void record (std::chrono::microseconds value);
+
+    std::uint64_t count () const;
+    std::chrono::microseconds sum () const;
+    std::chrono::microseconds max () const;
+    // The number of durations up to '2 ^ index' microseconds and longer than the previous bucket.
+    std::uint64_t bucket (std::size_t index) const;
+    // The upper bound of the bucket the quantile falls in.
+    std::chrono::microseconds quantile (double fraction) const;
+
+    private :
+    std::array<std::atomic<std::uint64_t>, bucket_count> buckets;
+    std::atomic<std::uint64_t> count_;
+    std::atomic<std::uint64_t> sum_;
+    std::atomic<std::uint64_t> max_;
+
+    private :
+    latency_histogram (const latency_histogram &) = delete;
+    latency_histogram & operator = (const latency_histogram &) = delete;
+};
+
+// What the lifecycle of 'application' went through so far.
+// Updated in the thread of 'application', and read without locks from any thread.
+struct background_library application_metrics
+{
+    // The times 'proceed ()' went around its loop.
+    std::atomic<std::uint64_t> proceed_iterations;
+    // The times proceeding was posted to the event loop, and the times it was already posted or running.
+    std::atomic<std::uint64_t> proceed_posted;
+    std::atomic<std::uint64_t> proceed_coalesced;
+    // The times proceeding was asked for while proceeding, and went around once more for it.
+    std::atomic<std::uint64_t> control_regained;
+    // The times proceeding was posted, but taken back to go on right away, see 'application::set_with_synchronous_proceeding ()'.
+    std::atomic<std::uint64_t> control_retaken;
+    std::atomic<std::uint64_t> system_events;
+    std::atomic<std::uint64_t> system_events_high_water_mark;
+    // The system events not queued as the same one was waiting already, and the ones not queued as the queue was full.
+    std::atomic<std::uint64_t> system_events_coalesced;
+    std::atomic<std::uint64_t> system_events_dropped;
+
+    // From being asked to stop, such as by a signal, until 'stop ()' is emitted.
+    latency_histogram stop_latency;
+    // The time spent in each 'service_state', indexed by its value.
+    std::array<latency_histogram, static_cast<std::size_t> (service_state::resuming) + 1> state_durations;
+
+    application_metrics ();
+    application_metrics (const application_metrics &) = delete;
+    application_metrics & operator = (const application_metrics &) = delete;
+};
+
+} // namespace background
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <QtNetwork/QTcpServer>
+#include <QtNetwork/QLocalServer>
+
+#include "background_application.hpp"
+#include "background_datatypes.hpp"
+
+// Requires linking 'Qt6::Network'. The library itself does not.
+
+namespace background
+{
+
+// Listens on the descriptor inherited under the name, such as a socket activated by the system.
+// The descriptor is taken from the application only once the server accepts it.
+bool listen_inherited (application & application, const QString & name, QTcpServer & server);
+bool listen_inherited (application & application, const QString & name, QLocalServer & server);
+
+} // namespace background
+
+namespace background
+{
+
+inline bool listen_inherited (application & application, const QString & name, QTcpServer & server)
+{
+    for (const auto & descriptor : application.inherited_descriptors ())
+    {
+        if (descriptor.name != name)
+            continue;
+        if (not server.setSocketDescriptor (descriptor.descriptor))
+            return false;
+        application.take_inherited_descriptor (name);
+        return true;
+    }
+    return false;
+}
+
+inline bool listen_inherited (application & application, const QString & name, QLocalServer & server)
+{
+    for (const auto & descriptor : application.inherited_descriptors ())
+    {
+        if (descriptor.name != name)
+            continue;
+        if (not server.listen (descriptor.descriptor))
+            return false;
+        application.take_inherited_descriptor (name);
+        return true;
+    }
+    return false;
+}
+
+} // namespace background
@@ -0,0 +1,30 @@
+#include "background_plugin_registry.hpp"
+
+namespace background
+{
+
+plugin_registry & plugin_registry::instance ()
+{
+    static plugin_registry instance;
+    return instance;
+}
+
+plugin_registry::plugin_registry ()
+{
+    // Reading the metadata decodes it, so it is done once for every interface at a time.
+    const auto plugins (QPluginLoader::staticPlugins ());
+    for (const auto & plugin : plugins)
+        static_plugins [plugin.metaData ().value (QStringLiteral ("IID")).toString ()].push_back (plugin);
+}
+
+std::vector<QStaticPlugin> plugin_registry::take_static_plugins (const QString & interface_id)
+{
+    const auto found (static_plugins.find (interface_id));
+    if (found == static_plugins.end ())
+        return {};
+    auto result (std::move (found->second));
+    static_plugins.erase (found);
+    return result;
+}
+
+} // namespace background
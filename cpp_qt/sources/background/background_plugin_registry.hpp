@@ -0,0 +1,79 @@
+#pragma once
+
+#include <vector>
+#include <map>
+#include <type_traits>
+#include <algorithm>
+
+#include <QtCore/QObject>
+#include <QtCore/QString>
+#include <QtCore/QMutex>
+#include <QtCore/QPluginLoader>
+
+namespace background
+{
+
+// The static plugins of the process by interface.
+// The metadata of all of them is read once, on the first lookup.
+// The plugins of an interface are only instantiated on the first lookup of that interface,
+// and kept sorted by 'order ()' where the interface has one.
+class plugin_registry
+{
+    public :
+    static plugin_registry & instance ();
+
+    public :
+    template <class T> std::vector<T *> plugins ();
+
+    private :
+    plugin_registry ();
+
+    std::vector<QStaticPlugin> take_static_plugins (const QString & interface_id);
+
+    private :
+    QMutex mutex;
+    std::map<QString, std::vector<QStaticPlugin>> static_plugins;
+    std::map<QString, std::vector<QObject *>> instances;
+
+    private :
+    Q_DISABLE_COPY (plugin_registry)
+};
+
+template <class T, class = void> struct has_order : std::false_type {};
+template <class T> struct has_order<T, std::void_t<decltype (std::declval<const T &> ().order ())>> : std::true_type {};
+
+template <class T> std::vector<T *> plugin_registry::plugins ()
+{
+    const QMutexLocker locker (& mutex);
+    const auto interface_id (QString::fromUtf8 (qobject_interface_iid<T *> ()));
+    auto found (instances.find (interface_id));
+    if (found == instances.end ())
+    {
+        std::vector<QObject *> plugins;
+        for (const auto & plugin : take_static_plugins (interface_id))
+        {
+            // The instance is kept by Qt for the lifetime of the process.
+            auto * const instance (qobject_cast<T *> (plugin.instance ()));
+            if (instance != nullptr)
+                plugins.push_back (instance);
+        }
+        if constexpr (has_order<T>::value)
+        {
+            std::stable_sort (
+                plugins.begin (), plugins.end (),
+                [] (QObject * const left, QObject * const right)
+                {
+                    return static_cast<T *> (left)->order () < static_cast<T *> (right)->order ();
+                }
+            );
+        }
+        found = instances.emplace (interface_id, std::move (plugins)).first;
+    }
+    std::vector<T *> result;
+    result.reserve (found->second.size ());
+    for (auto * const plugin : found->second)
+        result.push_back (static_cast<T *> (plugin));
+    return result;
+}
+
+} // namespace background
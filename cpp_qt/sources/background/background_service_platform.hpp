@@ -1,5 +1,7 @@
 #pragma once
 
+#include <chrono>
+
 #include <QtCore/QObject>
 
 #include "background_library.hpp"
@@ -25,6 +27,41 @@ class background_library service_platform : public QObject
 
     virtual void retrieve_configuration () = 0;
 
+    // Optional. Zero if the system does not watch the service.
+    // Otherwise 'keep_alive ()' is to be called more often than that while serving.
+    public :
+    virtual std::chrono::microseconds watchdog_interval () const;
+
+    public Q_SLOTS :
+    virtual void keep_alive ();
+
+    // Optional. Tells the system the service is reloading while serving, and is done with that.
+    // The failure is of no interest, same as with stopping.
+    public :
+    virtual void set_state_reloading ();
+    virtual void set_state_reloaded ();
+
+    // Optional. Same for pausing.
+    public :
+    virtual void set_state_pausing ();
+    virtual void set_state_paused ();
+    virtual void set_state_resuming ();
+    virtual void set_state_resumed ();
+
+    // Optional. Asks the system to wait that much longer for the service to start or stop.
+    public :
+    virtual void extend_timeout (std::chrono::microseconds timeout);
+
+    // Optional. Parks a descriptor with the system to be inherited by the next instance of the service.
+    // False if the system does not keep descriptors.
+    public :
+    virtual bool store_descriptor (const QString & name, qintptr descriptor);
+    virtual bool discard_stored_descriptor (const QString & name);
+
+    // Optional. Tells the system another process of the service took over serving, before this one exits.
+    public :
+    virtual void set_main_process_id (qint64 process_id);
+
     Q_SIGNALS :
     void started ();
     void failed_to_start (const application_error & error); // clazy:exclude=fully-qualified-moc-types
@@ -72,6 +109,48 @@ inline service_platform::service_platform (QObject * const parent)
     : QObject (parent)
 {}
 
+inline std::chrono::microseconds service_platform::watchdog_interval () const
+{
+    return std::chrono::microseconds::zero ();
+}
+
+inline void service_platform::keep_alive ()
+{}
+
+inline void service_platform::set_state_reloading ()
+{}
+
+inline void service_platform::set_state_reloaded ()
+{}
+
+inline void service_platform::set_state_pausing ()
+{}
+
+inline void service_platform::set_state_paused ()
+{}
+
+inline void service_platform::set_state_resuming ()
+{}
+
+inline void service_platform::set_state_resumed ()
+{}
+
+inline void service_platform::extend_timeout (std::chrono::microseconds)
+{}
+
+inline bool service_platform::store_descriptor (const QString &, qintptr)
+{
+    return false;
+}
+
+inline bool service_platform::discard_stored_descriptor (const QString &)
+{
+    return false;
+}
+
+inline void service_platform::set_main_process_id (qint64)
+{}
+
 inline service_platform_plugin::service_platform_plugin (QObject * const parent)
     : QObject (parent)
 {}
@@ -0,0 +1,442 @@
+#include "background_service_platform_systemd.hpp"
+
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <ctime>
+#include <variant>
+
+#include <signal.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <pwd.h>
+
+#include <QtCore/QFile>
+#include <QtCore/QCoreApplication>
+#include <QtCore/QtPlugin>
+#include <QtCore/QLoggingCategory>
+
+#include "background_datatypes.hpp"
+#include "background_signal_notifier_posix.hpp"
+
+static Q_LOGGING_CATEGORY (category, "background.application")
+
+namespace background
+{
+
+namespace
+{
+
+// The service manager socket is described by 'NOTIFY_SOCKET'.
+// A path of a datagram socket in the file system or, prefixed with '@', in the abstract namespace.
+// There is no need for 'libsystemd' to speak the protocol: a message is a single datagram of 'KEY=VALUE' lines.
+int socket_ (-1);
+sockaddr_un address;
+socklen_t address_size (0);
+
+bool parse_address ();
+bool notify (const QByteArray & message, int descriptor = -1);
+bool valid_descriptor_name (const QString & name);
+
+std::variant<service_configuration, application_error> retrieve_configuration_ ();
+
+application_error failed_to_connect ();
+application_error failed_to_subscribe_to_events ();
+application_error failed_to_set_state ();
+
+} // namespace
+
+service_platform_systemd::service_platform_systemd (QObject * const parent)
+    : service_platform (parent),
+    notifier (new signal_notifier_posix (this))
+{}
+
+service_platform_systemd::~service_platform_systemd ()
+{
+    if (socket_ == -1)
+        return;
+    ::close (socket_);
+    socket_ = -1;
+}
+
+bool service_platform_systemd::check ()
+{
+    // Only 'Type=notify' units are given the socket.
+    // Any other unit might as well be treated as a regular program.
+    return parse_address ();
+}
+
+void service_platform_systemd::start ()
+{
+    // The socket is not connected: the service manager may rebind the path when it is reexecuted.
+    // Non-blocking so that a stalled service manager never stalls the event loop.
+    socket_ = ::socket (AF_UNIX, SOCK_DGRAM bitor SOCK_CLOEXEC bitor SOCK_NONBLOCK, 0);
+    if (socket_ == -1)
+    {
+        Q_EMIT failed_to_start (failed_to_connect ());
+        return;
+    }
+    // The service manager asks to stop with 'KillSignal=', which is 'SIGTERM' by default,
+    // and to reload with 'ReloadSignal=' for 'Type=notify-reload' units, which is 'SIGHUP' by default.
+    connect (
+        notifier, & signal_notifier_posix::received,
+        this, & service_platform_systemd::process_event
+    );
+    if (not notifier->start ({ SIGTERM, SIGINT, SIGHUP }))
+    {
+        ::close (socket_);
+        socket_ = -1;
+        Q_EMIT failed_to_start (failed_to_subscribe_to_events ());
+        return;
+    }
+    Q_EMIT started ();
+}
+
+void service_platform_systemd::stop ()
+{
+    notifier->stop ();
+    if (socket_ != -1)
+    {
+        ::close (socket_);
+        socket_ = -1;
+    }
+    Q_EMIT stopped ();
+}
+
+void service_platform_systemd::set_state_serving ()
+{
+    if (not notify (QByteArrayLiteral ("READY=1")))
+    {
+        Q_EMIT failed_to_set_state_serving (failed_to_set_state ());
+        return;
+    }
+    Q_EMIT state_serving_set ();
+}
+
+void service_platform_systemd::set_state_stopping ()
+{
+    if (not notify (QByteArrayLiteral ("STOPPING=1")))
+        qCWarning (category).noquote () << text::with_last_error (QStringLiteral (
+            "Failed to set service state"
+        ));
+    Q_EMIT state_stopping_set ();
+}
+
+void service_platform_systemd::set_state_stopped (const int exit_code)
+{
+    if (not notify (QByteArrayLiteral ("EXIT_STATUS=").append (QByteArray::number (exit_code))))
+        qCWarning (category).noquote () << text::with_last_error (QStringLiteral (
+            "Failed to set service state"
+        ));
+    Q_EMIT state_stopped_set ();
+}
+
+void service_platform_systemd::retrieve_configuration ()
+{
+    const auto result (retrieve_configuration_ ());
+    if (std::holds_alternative<service_configuration> (result))
+        Q_EMIT configuration_retrieved (std::get<service_configuration> (result));
+    else
+        Q_EMIT failed_to_retrieve_configuration (std::get<application_error> (result));
+}
+
+std::chrono::microseconds service_platform_systemd::watchdog_interval () const
+{
+    // 'WatchdogSec='. The process id is only there to tell the main process from its children.
+    bool valid (false);
+    const auto interval (qgetenv ("WATCHDOG_USEC").toULongLong (& valid));
+    if (not valid or interval == 0)
+        return std::chrono::microseconds::zero ();
+    if (qEnvironmentVariableIsSet ("WATCHDOG_PID"))
+    {
+        const auto process_id (qgetenv ("WATCHDOG_PID").toLongLong (& valid));
+        if (not valid or process_id != static_cast<qint64> (::getpid ()))
+            return std::chrono::microseconds::zero ();
+    }
+    return std::chrono::microseconds (interval);
+}
+
+void service_platform_systemd::keep_alive ()
+{
+    if (not notify (QByteArrayLiteral ("WATCHDOG=1")))
+        qCWarning (category).noquote () << text::with_last_error (QStringLiteral (
+            "Failed to notify the watchdog"
+        ));
+}
+
+void service_platform_systemd::set_state_reloading ()
+{
+    // The timestamp tells this reload from the earlier ones that might still be in flight.
+    timespec now {};
+    ::clock_gettime (CLOCK_MONOTONIC, & now);
+    const auto timestamp (static_cast<qint64> (now.tv_sec) * 1000000 + now.tv_nsec / 1000);
+    if (not notify (QByteArrayLiteral ("RELOADING=1\nMONOTONIC_USEC=").append (QByteArray::number (timestamp))))
+        qCWarning (category).noquote () << text::with_last_error (QStringLiteral (
+            "Failed to set service state"
+        ));
+}
+
+void service_platform_systemd::set_state_reloaded ()
+{
+    if (not notify (QByteArrayLiteral ("READY=1")))
+        qCWarning (category).noquote () << text::with_last_error (QStringLiteral (
+            "Failed to set service state"
+        ));
+}
+
+void service_platform_systemd::extend_timeout (const std::chrono::microseconds timeout)
+{
+    // Extends 'TimeoutStartSec=' or 'TimeoutStopSec=' from now on, and not from the previous extension.
+    if (not notify (QByteArrayLiteral ("EXTEND_TIMEOUT_USEC=").append (QByteArray::number (static_cast<qint64> (timeout.count ())))))
+        qCWarning (category).noquote () << text::with_last_error (QStringLiteral (
+            "Failed to extend the timeout"
+        ));
+}
+
+bool service_platform_systemd::store_descriptor (const QString & name, const qintptr descriptor)
+{
+    // Only kept with 'FileDescriptorStoreMax=' set for the unit.
+    // The service manager drops a socket from the store by itself once the peer hangs up.
+    // What is stored is passed on every next start, same as with socket activation, until discarded.
+    if (not valid_descriptor_name (name) or descriptor < 0)
+    {
+        errno = EINVAL;
+        return false;
+    }
+    if (not notify (QByteArrayLiteral ("FDSTORE=1\nFDNAME=").append (name.toLatin1 ()), static_cast<int> (descriptor)))
+    {
+        qCWarning (category).noquote () << text::with_last_error (
+            QStringLiteral ("Failed to store descriptor '%1'").arg (name)
+        );
+        return false;
+    }
+    return true;
+}
+
+bool service_platform_systemd::discard_stored_descriptor (const QString & name)
+{
+    if (not valid_descriptor_name (name))
+    {
+        errno = EINVAL;
+        return false;
+    }
+    return notify (QByteArrayLiteral ("FDSTOREREMOVE=1\nFDNAME=").append (name.toLatin1 ()));
+}
+
+void service_platform_systemd::set_main_process_id (const qint64 process_id)
+{
+    // The new process only gets to notify with 'NotifyAccess=all' set for the unit.
+    if (not notify (QByteArrayLiteral ("MAINPID=").append (QByteArray::number (process_id))))
+        qCWarning (category).noquote () << text::with_last_error (QStringLiteral (
+            "Failed to pass the main process on"
+        ));
+}
+
+void service_platform_systemd::process_event (const int number)
+{
+    Q_EMIT event_received (
+        application_system_event
+        { // c++20 designated initializers
+            /*.action = */number == SIGHUP ? application_system_event::reload : application_system_event::stop,
+            /*.name = */signal_notifier_posix::name (number)
+        }
+    );
+}
+
+namespace
+{
+
+bool parse_address ()
+{
+    address_size = 0;
+    const auto value (qgetenv ("NOTIFY_SOCKET"));
+    if (value.size () < 2 or static_cast<std::size_t> (value.size ()) >= sizeof (address.sun_path))
+        return false;
+    if (value.front () != '/' and value.front () != '@')
+        return false;
+    std::memset (& address, 0, sizeof (address));
+    address.sun_family = AF_UNIX;
+    std::memcpy (address.sun_path, value.constData (), static_cast<std::size_t> (value.size ()));
+    address_size = static_cast<socklen_t> (offsetof (sockaddr_un, sun_path) + static_cast<std::size_t> (value.size ()));
+    if (address.sun_path [0] == '@')
+        address.sun_path [0] = '\0';
+    else
+        address_size += 1;
+    return true;
+}
+
+bool notify (const QByteArray & message, const int descriptor)
+{
+    if (socket_ == -1 or address_size == 0)
+    {
+        errno = ENOTCONN;
+        return false;
+    }
+    iovec data
+    { // c++20 designated initializers
+        /*.iov_base =*/const_cast<char *> (message.constData ()),
+        /*.iov_len =*/static_cast<std::size_t> (message.size ())
+    };
+    msghdr header {};
+    header.msg_name = & address;
+    header.msg_namelen = address_size;
+    header.msg_iov = & data;
+    header.msg_iovlen = 1;
+    // The descriptor travels along as ancillary data and is duplicated into the service manager.
+    alignas (cmsghdr) char control [CMSG_SPACE (sizeof (int))];
+    if (descriptor != -1)
+    {
+        std::memset (control, 0, sizeof (control));
+        header.msg_control = control;
+        header.msg_controllen = sizeof (control);
+        cmsghdr * const rights (CMSG_FIRSTHDR (& header));
+        rights->cmsg_level = SOL_SOCKET;
+        rights->cmsg_type = SCM_RIGHTS;
+        rights->cmsg_len = CMSG_LEN (sizeof (int));
+        std::memcpy (CMSG_DATA (rights), & descriptor, sizeof (int));
+    }
+    Q_FOREVER
+    {
+        if (::sendmsg (socket_, & header, MSG_NOSIGNAL) != -1)
+            return true;
+        if (errno != EINTR)
+            return false;
+    }
+}
+
+bool valid_descriptor_name (const QString & name)
+{
+    // The names are passed back in 'LISTEN_FDNAMES' separated with ':'.
+    if (name.isEmpty () or name.size () > 255)
+        return false;
+    for (const auto character : name)
+    {
+        if (character.unicode () < 0x21 or character.unicode () > 0x7e or character == ':')
+            return false;
+    }
+    return true;
+}
+
+std::variant<service_configuration, application_error> retrieve_configuration_ ()
+{
+    // The unit is the closest '.service' in the control group path of the process.
+    // The rest of the unit properties are only available over the bus.
+    QFile groups (QStringLiteral ("/proc/self/cgroup"));
+    if (not groups.open (QIODevice::ReadOnly bitor QIODevice::Text))
+        return application_error
+        { // c++20 designated initializers
+            /*.error =*/application_error::failed_to_retrieve_configuration,
+            /*.text =*/QStringLiteral (
+                "Failed to retrieve service configuration. "
+                "Failed to read the control group: %1."
+            ).arg (groups.errorString ())
+        };
+    QString name;
+    while (not groups.atEnd () and name.isEmpty ())
+    {
+        const auto line (QString::fromUtf8 (groups.readLine ()).trimmed ());
+        const auto path (line.mid (line.lastIndexOf (':') + 1));
+        const auto units (path.split ('/', Qt::SkipEmptyParts));
+        for (auto unit (units.crbegin ()); unit != units.crend (); ++unit)
+        {
+            if (not unit->endsWith (QStringLiteral (".service")))
+                continue;
+            name = * unit;
+            name.chop (8);
+            break;
+        }
+    }
+    if (name.isEmpty ())
+        return application_error
+        { // c++20 designated initializers
+            /*.error =*/application_error::failed_to_retrieve_configuration,
+            /*.text =*/QStringLiteral (
+                "Failed to retrieve service configuration. "
+                "Failed to find the service."
+            )
+        };
+
+    QString user;
+    if (const auto * const user_ (::getpwuid (::geteuid ())); user_ != nullptr)
+        user = QString::fromLocal8Bit (user_->pw_name);
+
+    return service_configuration
+    { // c++20 designated initializers
+        /*name =*/name,
+        /*description =*/QString (),
+        /*executable =*/QCoreApplication::applicationFilePath (),
+        /*user =*/user
+    };
+}
+
+application_error failed_to_connect ()
+{
+    return application_error
+    { // c++20 designated initializers
+        /*.error =*/application_error::failed_to_run,
+        /*.text =*/text::with_last_error (QStringLiteral (
+            "Failed to run as a service. "
+            "Failed to connect to the service manager"
+        ))
+    };
+}
+
+application_error failed_to_subscribe_to_events ()
+{
+    return application_error
+    { // c++20 designated initializers
+        /*.error =*/application_error::failed_to_run,
+        /*.text =*/text::with_last_error (QStringLiteral (
+            "Failed to run as a service. "
+            "Failed to subscribe to service events"
+        ))
+    };
+}
+
+application_error failed_to_set_state ()
+{
+    return application_error
+    { // c++20 designated initializers
+        /*.error =*/application_error::failed_to_run,
+        /*.text =*/text::with_last_error (QStringLiteral (
+            "Failed to run as a service. "
+            "Failed to set service state"
+        ))
+    };
+}
+
+} // namespace
+
+#if not defined background_no_plugins
+
+background_service_platform_plugin_systemd::background_service_platform_plugin_systemd (QObject * const parent)
+    : service_platform_plugin (parent)
+{}
+
+unsigned int background_service_platform_plugin_systemd::order () const
+{
+    return 99;
+}
+
+bool background_service_platform_plugin_systemd::detect ()
+{
+    // Without the socket, the process was not spawned by the service manager, or not as a 'Type=notify' unit,
+    // and there is no implementation for it as on any other platform without one.
+    // Whether the socket is usable is decided by 'check ()'.
+    return qEnvironmentVariableIsSet ("NOTIFY_SOCKET");
+}
+
+service_platform * background_service_platform_plugin_systemd::create (QObject * const parent)
+{
+    return new service_platform_systemd (parent);
+}
+
+#endif
+
+} // namespace background
+
+#if not defined background_no_plugins
+Q_IMPORT_PLUGIN (background_service_platform_plugin_systemd)
+#endif
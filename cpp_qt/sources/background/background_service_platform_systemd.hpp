@@ -0,0 +1,78 @@
+#pragma once
+
+#if not defined QT_STATICPLUGIN and not defined background_no_plugins
+#define QT_STATICPLUGIN
+#endif
+
+#include "background_service_platform.hpp"
+
+namespace background
+{
+
+class signal_notifier_posix;
+
+class service_platform_systemd : public service_platform
+{
+    public :
+    explicit service_platform_systemd (QObject * parent);
+    ~service_platform_systemd ();
+
+    public Q_SLOTS :
+    bool check () override;
+
+    void start () override;
+    void stop () override;
+
+    void set_state_serving () override;
+    void set_state_stopping () override;
+    void set_state_stopped (int exit_code) override;
+
+    void retrieve_configuration () override;
+
+    public :
+    std::chrono::microseconds watchdog_interval () const override;
+
+    public Q_SLOTS :
+    void keep_alive () override;
+
+    public :
+    void set_state_reloading () override;
+    void set_state_reloaded () override;
+    void extend_timeout (std::chrono::microseconds timeout) override;
+    bool store_descriptor (const QString & name, qintptr descriptor) override;
+    bool discard_stored_descriptor (const QString & name) override;
+    void set_main_process_id (qint64 process_id) override;
+
+    protected Q_SLOTS :
+    void process_event (int number);
+
+    private :
+    signal_notifier_posix * const notifier;
+
+    private :
+    Q_OBJECT
+    Q_DISABLE_COPY (service_platform_systemd)
+};
+
+#if not defined background_no_plugins
+
+class background_service_platform_plugin_systemd : public service_platform_plugin
+{
+    public :
+    explicit background_service_platform_plugin_systemd (QObject * parent = nullptr);
+
+    public :
+    unsigned int order () const override;
+    bool detect () override;
+    service_platform * create (QObject * parent = nullptr) override;
+
+    private :
+    Q_OBJECT
+    Q_DISABLE_COPY (background_service_platform_plugin_systemd)
+    Q_PLUGIN_METADATA (IID "background.service_platform_plugin")
+    Q_INTERFACES (background::service_platform_plugin)
+};
+
+#endif
+
+} // namespace background
@@ -49,6 +49,7 @@ SERVICE_STATUS_HANDLE service (nullptr);
 SERVICE_STATUS state { 0, 0, 0, 0, 0, 0, 0 };
 
 void run_service ();
+void set_state (DWORD value);
 
 extern "C" // Not required. WINAPI is already there.
 {
@@ -138,7 +139,7 @@ void service_platform_windows::start ()
             {
                 SERVICE_WIN32_OWN_PROCESS,
                 SERVICE_START_PENDING,
-                SERVICE_ACCEPT_STOP bitor SERVICE_ACCEPT_PRESHUTDOWN,
+                SERVICE_ACCEPT_STOP bitor SERVICE_ACCEPT_PRESHUTDOWN bitor SERVICE_ACCEPT_PARAMCHANGE bitor SERVICE_ACCEPT_PAUSE_CONTINUE,
                 NO_ERROR,
                 0,
                 0, 0
@@ -233,9 +234,11 @@ void service_platform_windows::stop ()
     }
     stopping = stopping_sequence::stop;
     // There is no static guarantee that 'StartServiceCtrlDispatcher ()' will actually unblock.
-    // A timer would not hurt.
+    // The stop timeout of 'application' bounds it when set.
     state.dwCurrentState = SERVICE_STOPPED;
     state.dwControlsAccepted = 0;
+    state.dwCheckPoint = 0;
+    state.dwWaitHint = 0;
     auto * const service_ (service);
     service = nullptr;
     if (not SetServiceStatus (service_, & state))
@@ -264,6 +267,8 @@ void service_platform_windows::set_state_serving ()
         return;
     }
     state.dwCurrentState = SERVICE_RUNNING;
+    state.dwCheckPoint = 0;
+    state.dwWaitHint = 0;
     if (not SetServiceStatus (service, & state))
     {
         Q_EMIT failed_to_set_state_serving (failed_to_set_state ());
@@ -293,6 +298,47 @@ void service_platform_windows::set_state_stopped (const int exit_code)
     Q_EMIT state_stopped_set ();
 }
 
+void service_platform_windows::set_state_pausing ()
+{
+    set_state (SERVICE_PAUSE_PENDING);
+}
+
+void service_platform_windows::set_state_paused ()
+{
+    set_state (SERVICE_PAUSED);
+}
+
+void service_platform_windows::set_state_resuming ()
+{
+    set_state (SERVICE_CONTINUE_PENDING);
+}
+
+void service_platform_windows::set_state_resumed ()
+{
+    set_state (SERVICE_RUNNING);
+}
+
+void service_platform_windows::extend_timeout (const std::chrono::microseconds timeout)
+{
+    // The service control manager keeps waiting as long as the check point advances within the wait hint.
+    if (service == nullptr)
+        return;
+    switch (state.dwCurrentState)
+    {
+        case SERVICE_START_PENDING :
+        case SERVICE_STOP_PENDING :
+        case SERVICE_PAUSE_PENDING :
+        case SERVICE_CONTINUE_PENDING : break;
+        default : return;
+    }
+    state.dwCheckPoint += 1;
+    state.dwWaitHint = static_cast<DWORD> (std::chrono::duration_cast<std::chrono::milliseconds> (timeout).count ());
+    if (not SetServiceStatus (service, & state))
+        qCWarning (category).noquote () << text::with_last_error (QStringLiteral (
+            "Failed to extend the timeout"
+        ));
+}
+
 void service_platform_windows::retrieve_configuration ()
 {
     const auto result (retrieve_configuration_ ());
@@ -310,13 +356,26 @@ void service_platform_windows::process_event (const unsigned long event)
         {
             case SERVICE_CONTROL_STOP : return QStringLiteral ("stop");
             case SERVICE_CONTROL_PRESHUTDOWN : return QStringLiteral ("shutdown");
+            case SERVICE_CONTROL_PARAMCHANGE : return QStringLiteral ("parameters change");
+            case SERVICE_CONTROL_PAUSE : return QStringLiteral ("pause");
+            case SERVICE_CONTROL_CONTINUE : return QStringLiteral ("continue");
             default : Q_UNREACHABLE (); return QString ();
         }
     };
+    const auto event_action = [] (const unsigned long event)
+    {
+        switch (event)
+        {
+            case SERVICE_CONTROL_PARAMCHANGE : return application_system_event::reload;
+            case SERVICE_CONTROL_PAUSE : return application_system_event::pause;
+            case SERVICE_CONTROL_CONTINUE : return application_system_event::resume;
+            default : return application_system_event::stop;
+        }
+    };
     Q_EMIT event_received (
         application_system_event
         { // c++20 designated initializers
-            /*.action = */application_system_event::stop,
+            /*.action = */event_action (event),
             /*.name = */event_name (event)
         }
     );
@@ -325,6 +384,20 @@ void service_platform_windows::process_event (const unsigned long event)
 namespace
 {
 
+// The failure is of no interest.
+void set_state (const DWORD value)
+{
+    if (service == nullptr)
+        return;
+    state.dwCurrentState = value;
+    state.dwCheckPoint = 0;
+    state.dwWaitHint = 0;
+    if (not SetServiceStatus (service, & state))
+        qCWarning (category).noquote () << text::with_last_error (QStringLiteral (
+            "Failed to set service state"
+        ));
+}
+
 void run_service ()
 {
     const QString name;
@@ -395,6 +468,9 @@ DWORD QT_WIN_CALLBACK process_service_event (
     {
         case SERVICE_CONTROL_STOP :
         case SERVICE_CONTROL_PRESHUTDOWN :
+        case SERVICE_CONTROL_PARAMCHANGE :
+        case SERVICE_CONTROL_PAUSE :
+        case SERVICE_CONTROL_CONTINUE :
         {
             QMutexLocker locker (& mutex);
             if (instance == nullptr)
@@ -691,6 +767,8 @@ bool should_try_running_as_a_service ()
 
 #endif
 
+#if not defined background_no_plugins
+
 background_service_platform_plugin_windows::background_service_platform_plugin_windows (QObject * const parent)
     : service_platform_plugin (parent)
 {}
@@ -710,6 +788,10 @@ service_platform * background_service_platform_plugin_windows::create (QObject *
     return new service_platform_windows (parent);
 }
 
+#endif
+
 } // namespace background
 
+#if not defined background_no_plugins
 Q_IMPORT_PLUGIN (background_service_platform_plugin_windows)
+#endif
@@ -1,6 +1,6 @@
 #pragma once
 
-#if not defined QT_STATICPLUGIN
+#if not defined QT_STATICPLUGIN and not defined background_no_plugins
 #define QT_STATICPLUGIN
 #endif
 
@@ -27,6 +27,13 @@ class service_platform_windows : public service_platform
 
     void retrieve_configuration () override;
 
+    public :
+    void set_state_pausing () override;
+    void set_state_paused () override;
+    void set_state_resuming () override;
+    void set_state_resumed () override;
+    void extend_timeout (std::chrono::microseconds timeout) override;
+
     Q_SIGNALS :
     void proceed_ ();
     void event_received_ (unsigned long event);
@@ -39,6 +46,8 @@ class service_platform_windows : public service_platform
     Q_DISABLE_COPY (service_platform_windows)
 };
 
+#if not defined background_no_plugins
+
 class background_service_platform_plugin_windows : public service_platform_plugin
 {
     public :
@@ -56,4 +65,6 @@ class background_service_platform_plugin_windows : public service_platform_plugi
     Q_INTERFACES (background::service_platform_plugin)
 };
 
+#endif
+
 } // namespace background
@@ -0,0 +1,190 @@
+#include "background_signal_notifier_posix.hpp"
+
+#include <atomic>
+#include <cerrno>
+
+#include <sys/signalfd.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include <QtCore/QSocketNotifier>
+
+namespace background
+{
+
+namespace
+{
+
+// The write end of the pipe the handler writes into.
+// There may only be a single notifier falling back to handling signals at a time.
+std::atomic<int> pipe_ (-1);
+struct sigaction previous_actions [NSIG];
+
+extern "C"
+{
+
+void process_signal (int number);
+
+} // extern "C"
+
+} // namespace
+
+signal_notifier_posix::signal_notifier_posix (QObject * const parent)
+    : QObject (parent),
+    descriptor (-1),
+    handling (false),
+    notifier (nullptr)
+{
+    sigemptyset (& numbers);
+    sigemptyset (& blocked);
+}
+
+signal_notifier_posix::~signal_notifier_posix ()
+{
+    stop ();
+}
+
+bool signal_notifier_posix::start (const std::initializer_list<int> numbers_)
+{
+    if (descriptor != -1)
+        return true;
+    sigemptyset (& numbers);
+    for (const auto number : numbers_)
+        sigaddset (& numbers, number);
+
+    // Blocking only affects the current thread and the threads started after.
+    // The threads started before have to block the signals themselves, or they might be delivered there.
+    sigset_t previous;
+    if (pthread_sigmask (SIG_BLOCK, & numbers, & previous) == 0)
+    {
+        descriptor = ::signalfd (-1, & numbers, SFD_NONBLOCK bitor SFD_CLOEXEC);
+        if (descriptor != -1)
+        {
+            sigemptyset (& blocked);
+            for (const auto number : numbers_)
+            {
+                if (not sigismember (& previous, number))
+                    sigaddset (& blocked, number);
+            }
+        }
+        else
+            pthread_sigmask (SIG_SETMASK, & previous, nullptr);
+    }
+
+    if (descriptor == -1)
+    {
+        int pipe [2];
+        if (::pipe2 (pipe, O_NONBLOCK bitor O_CLOEXEC) == -1)
+            return false;
+        int expected (-1);
+        if (not pipe_.compare_exchange_strong (expected, pipe [1]))
+        {
+            ::close (pipe [0]);
+            ::close (pipe [1]);
+            errno = EBUSY;
+            return false;
+        }
+        struct sigaction action {};
+        action.sa_handler = & process_signal;
+        sigfillset (& action.sa_mask);
+        action.sa_flags = SA_RESTART;
+        for (const auto number : numbers_)
+            sigaction (number, & action, & previous_actions [number]);
+        descriptor = pipe [0];
+        handling = true;
+    }
+
+    notifier = new QSocketNotifier (descriptor, QSocketNotifier::Read, this);
+    connect (notifier, & QSocketNotifier::activated, this, & signal_notifier_posix::process);
+    return true;
+}
+
+void signal_notifier_posix::stop ()
+{
+    if (descriptor == -1)
+        return;
+    delete notifier;
+    notifier = nullptr;
+    if (handling)
+    {
+        for (int number (1); number < NSIG; ++number)
+        {
+            if (sigismember (& numbers, number))
+                sigaction (number, & previous_actions [number], nullptr);
+        }
+        ::close (pipe_.exchange (-1));
+    }
+    else
+    {
+        // Whatever is pending now would be delivered by default when unblocked.
+        signalfd_siginfo buffer [8];
+        while (::read (descriptor, buffer, sizeof (buffer)) > 0);
+        pthread_sigmask (SIG_UNBLOCK, & blocked, nullptr);
+    }
+    ::close (descriptor);
+    descriptor = -1;
+    handling = false;
+}
+
+QString signal_notifier_posix::name (const int number)
+{
+    switch (number)
+    {
+        case SIGINT : return QStringLiteral ("interrupt");
+        case SIGTERM : return QStringLiteral ("terminate");
+        case SIGHUP : return QStringLiteral ("hang up");
+        case SIGQUIT : return QStringLiteral ("quit");
+        case SIGTSTP : return QStringLiteral ("terminal stop");
+        case SIGCONT : return QStringLiteral ("continue");
+        default : return QStringLiteral ("signal %1").arg (number);
+    }
+}
+
+void signal_notifier_posix::process ()
+{
+    if (handling)
+    {
+        unsigned char buffer [64];
+        Q_FOREVER
+        {
+            const auto size (::read (descriptor, buffer, sizeof (buffer)));
+            if (size <= 0)
+                break;
+            for (ssize_t i (0); i < size; ++i)
+                Q_EMIT received (buffer [i]);
+        }
+        return;
+    }
+    signalfd_siginfo buffer [8];
+    Q_FOREVER
+    {
+        const auto size (::read (descriptor, buffer, sizeof (buffer)));
+        if (size <= 0)
+            break;
+        for (std::size_t i (0); i < static_cast<std::size_t> (size) / sizeof (signalfd_siginfo); ++i)
+            Q_EMIT received (static_cast<int> (buffer [i].ssi_signo));
+    }
+}
+
+namespace
+{
+
+extern "C"
+{
+
+// Called in whichever thread the signal is delivered to, interrupting it.
+// Only async-signal-safe functions here.
+void process_signal (const int number)
+{
+    const auto error (errno);
+    const auto byte (static_cast<unsigned char> (number));
+    [[ maybe_unused ]] const auto result (::write (pipe_.load (std::memory_order_relaxed), & byte, 1));
+    errno = error;
+}
+
+} // extern "C"
+
+} // namespace
+
+} // namespace background
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <initializer_list>
+
+#include <signal.h>
+
+#include <QtCore/QObject>
+
+class QSocketNotifier;
+
+namespace background
+{
+
+// Delivers process signals in the thread the object lives in through the event loop.
+// Costs no thread and takes no lock: the signals are blocked and read from a 'signalfd',
+// or, where it is not available, written into a pipe by a handler.
+class signal_notifier_posix : public QObject
+{
+    public :
+    explicit signal_notifier_posix (QObject * parent);
+    ~signal_notifier_posix ();
+
+    public :
+    bool start (std::initializer_list<int> numbers);
+    void stop ();
+
+    static QString name (int number);
+
+    Q_SIGNALS :
+    void received (int number);
+
+    protected Q_SLOTS :
+    void process ();
+
+    private :
+    sigset_t numbers;
+    sigset_t blocked;
+    int descriptor;
+    bool handling;
+    QSocketNotifier * notifier;
+
+    private :
+    Q_OBJECT
+    Q_DISABLE_COPY (signal_notifier_posix)
+};
+
+} // namespace background
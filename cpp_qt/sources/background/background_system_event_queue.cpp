@@ -0,0 +1,80 @@
+#include "background_system_event_queue.hpp"
+
+#include <utility>
+
+namespace background
+{
+
+system_event_queue::system_event_queue ()
+    : first (0),
+    size_ (0)
+{}
+
+system_event_queue::push_result system_event_queue::push (const application_system_event & event)
+{
+    switch (event.action)
+    {
+        case application_system_event::pause :
+        case application_system_event::resume :
+        if (size_ != 0 and at (size_ - 1).action == event.action)
+            return push_result::coalesced;
+        break;
+
+        default :
+        for (std::size_t i (0); i < size_; ++i)
+        {
+            if (at (i).action == event.action)
+                return push_result::coalesced;
+        }
+        break;
+    }
+    if (size_ == capacity)
+    {
+        if (event.action != application_system_event::stop)
+            return push_result::dropped;
+        at (size_ - 1) = event;
+        return push_result::replaced;
+    }
+    at (size_) = event;
+    ++size_;
+    return push_result::queued;
+}
+
+application_system_event system_event_queue::pop ()
+{
+    auto result (std::move (at (0)));
+    // Releases the name.
+    at (0) = application_system_event {};
+    first = (first + 1) % capacity;
+    --size_;
+    return result;
+}
+
+void system_event_queue::clear ()
+{
+    while (size_ != 0)
+        pop ();
+    first = 0;
+}
+
+bool system_event_queue::empty () const
+{
+    return size_ == 0;
+}
+
+std::size_t system_event_queue::size () const
+{
+    return size_;
+}
+
+application_system_event & system_event_queue::at (const std::size_t index)
+{
+    return events [(first + index) % capacity];
+}
+
+const application_system_event & system_event_queue::at (const std::size_t index) const
+{
+    return events [(first + index) % capacity];
+}
+
+} // namespace background
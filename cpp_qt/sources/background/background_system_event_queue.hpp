@@ -0,0 +1,51 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+
+#include "background_datatypes.hpp"
+
+namespace background
+{
+
+// The system events waiting to be handled, in a ring of a fixed capacity.
+// A storm of signals does not grow it: an event already waiting is not queued again.
+// Stopping, reloading and memory pressure make no difference when repeated, so they are waited on once.
+// Pausing and resuming only coalesce with the latest event, as their order matters.
+// Queueing does not allocate. The names are implicitly shared, mostly literals, so copying one is not allocating either.
+class system_event_queue
+{
+    public :
+    static constexpr std::size_t capacity = 32;
+
+    enum class push_result
+    {
+        queued,
+        coalesced,
+        // Full. A stop is never dropped, it takes the place of the latest event instead.
+        dropped,
+        replaced
+    };
+
+    public :
+    system_event_queue ();
+
+    public :
+    push_result push (const application_system_event & event);
+    application_system_event pop ();
+    void clear ();
+
+    bool empty () const;
+    std::size_t size () const;
+
+    private :
+    application_system_event & at (std::size_t index);
+    const application_system_event & at (std::size_t index) const;
+
+    private :
+    std::array<application_system_event, capacity> events;
+    std::size_t first;
+    std::size_t size_;
+};
+
+} // namespace background
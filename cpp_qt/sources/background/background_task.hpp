@@ -0,0 +1,484 @@
+#pragma once
+
+// The coroutines take C++20, while the library itself is built as C++17.
+// So this is all in the header, and empty where coroutines are not available.
+#if defined __cpp_impl_coroutine and __has_include (<coroutine>)
+
+#include <coroutine>
+#include <chrono>
+#include <exception>
+#include <functional>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <QtCore/QObject>
+#include <QtCore/QTimer>
+#include <QtCore/QFuture>
+#include <QtCore/QFutureWatcher>
+
+#include "background_application.hpp"
+
+namespace background
+{
+
+template <class T = void>
+class task;
+
+namespace task_details
+{
+
+class promise_base
+{
+    public :
+    std::suspend_always initial_suspend () noexcept
+    {
+        return {};
+    }
+
+    // Resumes the awaiting coroutine, or calls back the one that started the task.
+    // The callback may destroy the task: nothing is touched after.
+    struct final_awaiter
+    {
+        bool await_ready () noexcept
+        {
+            return false;
+        }
+
+        template <class promise>
+        std::coroutine_handle<> await_suspend (const std::coroutine_handle<promise> handle) noexcept
+        {
+            auto & promise_ (handle.promise ());
+            if (promise_.continuation)
+                return promise_.continuation;
+            if (promise_.done)
+            {
+                const auto done (std::move (promise_.done));
+                done ();
+            }
+            return std::noop_coroutine ();
+        }
+
+        void await_resume () noexcept
+        {}
+    };
+
+    final_awaiter final_suspend () noexcept
+    {
+        return {};
+    }
+
+    void unhandled_exception () noexcept
+    {
+        exception = std::current_exception ();
+    }
+
+    public :
+    std::coroutine_handle<> continuation;
+    std::function<void ()> done;
+    std::exception_ptr exception;
+};
+
+template <class T>
+class promise : public promise_base
+{
+    public :
+    task<T> get_return_object () noexcept;
+
+    template <class value_type>
+    void return_value (value_type && value)
+    {
+        this->value.emplace (std::forward<value_type> (value));
+    }
+
+    T result ()
+    {
+        if (exception)
+            std::rethrow_exception (exception);
+        return std::move (value.value ());
+    }
+
+    public :
+    std::optional<T> value;
+};
+
+template <>
+class promise<void> : public promise_base
+{
+    public :
+    task<void> get_return_object () noexcept;
+
+    void return_void () noexcept
+    {}
+
+    void result ()
+    {
+        if (exception)
+            std::rethrow_exception (exception);
+    }
+};
+
+} // namespace task_details
+
+// A coroutine run on the thread of the event loop, starting once awaited or started.
+// Destroying a task that awaits destroys what it awaits, which cancels it:
+// the connections are disconnected and the timers are stopped.
+template <class T>
+class task
+{
+    public :
+    using promise_type = task_details::promise<T>;
+
+    public :
+    task () noexcept
+        : handle (nullptr)
+    {}
+
+    explicit task (const std::coroutine_handle<promise_type> handle) noexcept
+        : handle (handle)
+    {}
+
+    task (task && other) noexcept
+        : handle (std::exchange (other.handle, nullptr))
+    {}
+
+    task & operator = (task && other) noexcept
+    {
+        if (this != & other)
+        {
+            if (handle)
+                handle.destroy ();
+            handle = std::exchange (other.handle, nullptr);
+        }
+        return * this;
+    }
+
+    ~task ()
+    {
+        if (handle)
+            handle.destroy ();
+    }
+
+    public :
+    bool valid () const noexcept
+    {
+        return static_cast<bool> (handle);
+    }
+
+    bool done () const noexcept
+    {
+        return handle and handle.done ();
+    }
+
+    // Starts the task outside of a coroutine. 'done' is called once it returned or threw.
+    void start (std::function<void ()> done)
+    {
+        handle.promise ().done = std::move (done);
+        handle.resume ();
+    }
+
+    // Once done. Rethrows what the coroutine threw.
+    T result ()
+    {
+        return handle.promise ().result ();
+    }
+
+    auto operator co_await () && noexcept
+    {
+        struct awaiter
+        {
+            bool await_ready () noexcept
+            {
+                return false;
+            }
+
+            std::coroutine_handle<> await_suspend (const std::coroutine_handle<> continuation) noexcept
+            {
+                handle.promise ().continuation = continuation;
+                return handle;
+            }
+
+            T await_resume ()
+            {
+                return handle.promise ().result ();
+            }
+
+            std::coroutine_handle<promise_type> handle;
+        };
+        return awaiter { handle };
+    }
+
+    private :
+    std::coroutine_handle<promise_type> handle;
+
+    private :
+    task (const task &) = delete;
+    task & operator = (const task &) = delete;
+};
+
+namespace task_details
+{
+
+template <class T>
+task<T> promise<T>::get_return_object () noexcept
+{
+    return task<T> (std::coroutine_handle<promise<T>>::from_promise (* this));
+}
+
+inline task<void> promise<void>::get_return_object () noexcept
+{
+    return task<void> (std::coroutine_handle<promise<void>>::from_promise (* this));
+}
+
+} // namespace task_details
+
+// Resumes once the time passed.
+class delay
+{
+    public :
+    explicit delay (const std::chrono::milliseconds interval)
+        : interval (interval)
+    {
+        timer.setSingleShot (true);
+    }
+
+    public :
+    bool await_ready () const noexcept
+    {
+        return interval <= std::chrono::milliseconds::zero ();
+    }
+
+    void await_suspend (const std::coroutine_handle<> continuation)
+    {
+        QObject::connect (& timer, & QTimer::timeout, & timer, [continuation] () { continuation.resume (); });
+        timer.start (interval);
+    }
+
+    void await_resume () noexcept
+    {}
+
+    private :
+    const std::chrono::milliseconds interval;
+    QTimer timer;
+};
+
+// Resumes once the sender emits the signal. The arguments are not passed along.
+template <class sender_type, class signal_type>
+class next_signal
+{
+    public :
+    next_signal (const sender_type * const sender_, const signal_type signal_)
+        : sender_ (sender_),
+        signal_ (signal_)
+    {}
+
+    ~next_signal ()
+    {
+        QObject::disconnect (connection);
+    }
+
+    public :
+    bool await_ready () const noexcept
+    {
+        return false;
+    }
+
+    void await_suspend (const std::coroutine_handle<> continuation)
+    {
+        connection = QObject::connect (
+            sender_, signal_, sender_,
+            [continuation] () { continuation.resume (); },
+            Qt::SingleShotConnection
+        );
+    }
+
+    void await_resume () noexcept
+    {}
+
+    private :
+    const sender_type * const sender_;
+    const signal_type signal_;
+    QMetaObject::Connection connection;
+
+    private :
+    next_signal (const next_signal &) = delete;
+    next_signal & operator = (const next_signal &) = delete;
+};
+
+// Resumes once the future finished, with its result.
+template <class T>
+class future
+{
+    public :
+    explicit future (const QFuture<T> & future_)
+        : future_ (future_)
+    {}
+
+    public :
+    bool await_ready () const
+    {
+        return future_.isFinished ();
+    }
+
+    void await_suspend (const std::coroutine_handle<> continuation)
+    {
+        QObject::connect (
+            & watcher, & QFutureWatcher<T>::finished, & watcher,
+            [continuation] () { continuation.resume (); }
+        );
+        watcher.setFuture (future_);
+    }
+
+    T await_resume ()
+    {
+        if constexpr (not std::is_void_v<T>)
+            return future_.result ();
+    }
+
+    private :
+    QFuture<T> future_;
+    QFutureWatcher<T> watcher;
+};
+
+// Runs the tasks at the same time, resuming once all are done, with their results in order.
+// Rethrows the first exception in order, after all are done. Not for 'task<void>', return a value instead.
+template <class T>
+task<std::vector<T>> when_all (std::vector<task<T>> tasks)
+{
+    struct awaiter
+    {
+        bool await_ready () const noexcept
+        {
+            return tasks.empty ();
+        }
+
+        // Not suspended where all the tasks were done right away.
+        bool await_suspend (const std::coroutine_handle<> continuation_)
+        {
+            continuation = continuation_;
+            pending = tasks.size () + 1;
+            for (auto & task_ : tasks)
+            {
+                task_.start (
+                    [this] ()
+                    {
+                        if (--pending == 0)
+                            continuation.resume ();
+                    }
+                );
+            }
+            return --pending != 0;
+        }
+
+        void await_resume () noexcept
+        {}
+
+        std::vector<task<T>> & tasks;
+        std::coroutine_handle<> continuation;
+        std::size_t pending;
+    };
+    co_await awaiter { tasks, nullptr, 0 };
+    std::vector<T> results;
+    results.reserve (tasks.size ());
+    for (auto & task_ : tasks)
+        results.push_back (task_.result ());
+    co_return results;
+}
+
+// Runs the start and the stop handlers of 'application' as coroutines.
+// The application is set started or failed to start as the start coroutine returns true or false, or throws,
+// and set stopped as the stop coroutine returns or throws.
+// With 'application::set_with_stop_starting ()', stopping destroys the start coroutine where it awaits,
+// cancelling it, before the stop coroutine is run.
+class coroutine_handlers
+{
+    public :
+    explicit coroutine_handlers (application & application_)
+        : application_ (application_)
+    {
+        start_connection = QObject::connect (
+            & application_, & application::start, & application_,
+            [this] () { process_start (); }
+        );
+        stop_connection = QObject::connect (
+            & application_, & application::stop, & application_,
+            [this] () { process_stop (); }
+        );
+    }
+
+    ~coroutine_handlers ()
+    {
+        QObject::disconnect (start_connection);
+        QObject::disconnect (stop_connection);
+    }
+
+    public :
+    coroutine_handlers & set_start (std::function<task<bool> ()> start)
+    {
+        this->start = std::move (start);
+        return * this;
+    }
+
+    coroutine_handlers & set_stop (std::function<task<> ()> stop)
+    {
+        this->stop = std::move (stop);
+        return * this;
+    }
+
+    private :
+    void process_start ()
+    {
+        if (not start)
+        {
+            application_.set_started ();
+            return;
+        }
+        starting = start ();
+        starting.start (
+            [this] ()
+            {
+                bool started (false);
+                try
+                {
+                    started = starting.result ();
+                }
+                catch (...)
+                {}
+                if (started)
+                    application_.set_started ();
+                else
+                    application_.set_failed_to_start ();
+            }
+        );
+    }
+
+    void process_stop ()
+    {
+        starting = task<bool> ();
+        if (not stop)
+        {
+            application_.set_stopped ();
+            return;
+        }
+        stopping = stop ();
+        stopping.start ([this] () { application_.set_stopped (); });
+    }
+
+    private :
+    application & application_;
+    std::function<task<bool> ()> start;
+    std::function<task<> ()> stop;
+    task<bool> starting;
+    task<> stopping;
+    QMetaObject::Connection start_connection;
+    QMetaObject::Connection stop_connection;
+
+    private :
+    coroutine_handlers (const coroutine_handlers &) = delete;
+    coroutine_handlers & operator = (const coroutine_handlers &) = delete;
+};
+
+} // namespace background
+
+#endif
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <vector>
+
+#include <QtCore/QObject>
+#include <QtCore/QStringList>
+
+#include "background_datatypes.hpp"
+
+class QSocketNotifier;
+class QTimer;
+
+namespace background
+{
+
+// Starts a new instance of the program to hand serving over to,
+// passing it descriptors and a state the same way as with socket activation.
+// The new instance tells it is serving through a pipe passed along, or it exits.
+class upgrade_process : public QObject
+{
+    public :
+    explicit upgrade_process (QObject * parent);
+    ~upgrade_process ();
+
+    public :
+    bool start (
+        const QString & program, const QStringList & arguments,
+        const std::vector<inherited_descriptor> & descriptors, const QByteArray & state
+    );
+    // Of the last instance started.
+    qint64 process_id () const;
+
+    // The names of the descriptors only the library itself takes in the new instance.
+    static QString ready_name ();
+    static QString state_name ();
+
+    // In the new instance.
+    static void report_ready (qintptr descriptor);
+    static QByteArray read_state (qintptr descriptor);
+
+    Q_SIGNALS :
+    void finished (bool ready);
+
+    protected Q_SLOTS :
+    void process ();
+    void reap ();
+
+    private :
+    qint64 process_id_;
+    int descriptor;
+    QSocketNotifier * notifier;
+    // Failed instances that have not exited yet, waited for from a timer rather than blocking the event loop.
+    std::vector<qint64> exiting;
+    QTimer * reaper;
+
+    private :
+    Q_OBJECT
+    Q_DISABLE_COPY (upgrade_process)
+};
+
+} // namespace background
@@ -0,0 +1,308 @@
+#include "background_upgrade_process.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <algorithm>
+
+#include <signal.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+#include <QtCore/QFile>
+#include <QtCore/QSocketNotifier>
+#include <QtCore/QTimer>
+#include <QtCore/QScopeGuard>
+
+extern char ** environ;
+
+namespace background
+{
+
+namespace
+{
+
+// 'SD_LISTEN_FDS_START'.
+constexpr int first_descriptor (3);
+
+int duplicate (int descriptor, int lowest);
+int create_state (const QByteArray & state);
+
+} // namespace
+
+upgrade_process::upgrade_process (QObject * const parent)
+    : QObject (parent),
+    process_id_ (-1),
+    descriptor (-1),
+    notifier (nullptr),
+    reaper (nullptr)
+{}
+
+upgrade_process::~upgrade_process ()
+{
+    delete notifier;
+    if (descriptor != -1)
+        ::close (descriptor);
+}
+
+bool upgrade_process::start (
+    const QString & program, const QStringList & arguments,
+    const std::vector<inherited_descriptor> & descriptors, const QByteArray & state
+)
+{
+    if (descriptor != -1)
+    {
+        errno = EBUSY;
+        return false;
+    }
+
+    // Everything is prepared beforehand:
+    // the process is multithreaded, so the child may only call async-signal-safe functions until 'exec'.
+    // The descriptors are duplicated above the range they are moved into, so that moving does not overwrite them.
+    // The descriptors passed along, the state if any, and the end of the pipe to tell it is serving.
+    const auto lowest (first_descriptor + static_cast<int> (descriptors.size ()) + (state.isEmpty () ? 1 : 2));
+    std::vector<int> sources;
+    const auto clean_up (qScopeGuard (
+        [& sources] ()
+        {
+            for (const auto source : sources)
+                ::close (source);
+        }
+    ));
+    QByteArray names;
+    for (const auto & descriptor_ : descriptors)
+    {
+        if (descriptor_.name.isEmpty () or descriptor_.name.contains (QLatin1Char (':')))
+        {
+            errno = EINVAL;
+            return false;
+        }
+        const auto source (duplicate (static_cast<int> (descriptor_.descriptor), lowest));
+        if (source == -1)
+            return false;
+        sources.push_back (source);
+        names.append (descriptor_.name.toUtf8 ()).append (':');
+    }
+    if (not state.isEmpty ())
+    {
+        const auto state_ (create_state (state));
+        if (state_ == -1)
+            return false;
+        const auto source (duplicate (state_, lowest));
+        ::close (state_);
+        if (source == -1)
+            return false;
+        sources.push_back (source);
+        names.append (state_name ().toUtf8 ()).append (':');
+    }
+    int pipe [2];
+    if (::pipe2 (pipe, O_CLOEXEC) == -1)
+        return false;
+    {
+        const auto source (duplicate (pipe [1], lowest));
+        // Only the new instance keeps the write end, the end of file tells it is gone.
+        ::close (pipe [1]);
+        if (source == -1)
+        {
+            ::close (pipe [0]);
+            return false;
+        }
+        sources.push_back (source);
+        names.append (ready_name ().toUtf8 ());
+    }
+
+    const auto program_ (QFile::encodeName (program));
+    std::vector<QByteArray> arguments_ { program_ };
+    for (const auto & argument : arguments)
+        arguments_.push_back (argument.toLocal8Bit ());
+    std::vector<char *> argv;
+    for (auto & argument : arguments_)
+        argv.push_back (argument.data ());
+    argv.push_back (nullptr);
+
+    std::vector<QByteArray> environment;
+    for (char ** variable (environ); * variable != nullptr; ++variable)
+    {
+        if (std::strncmp (* variable, "LISTEN_", 7) == 0)
+            continue;
+        environment.emplace_back (* variable);
+    }
+    environment.push_back (QByteArrayLiteral ("LISTEN_FDS=").append (QByteArray::number (static_cast<int> (sources.size ()))));
+    environment.push_back (QByteArrayLiteral ("LISTEN_FDNAMES=").append (names));
+    // Filled in by the child.
+    environment.push_back (QByteArrayLiteral ("LISTEN_PID=").append (QByteArray (20, '\0')));
+    char * const process_id_value (environment.back ().data () + 11);
+    std::vector<char *> envp;
+    for (auto & variable : environment)
+        envp.push_back (variable.data ());
+    envp.push_back (nullptr);
+
+    sigset_t mask;
+    sigemptyset (& mask);
+
+    const auto process_id (::fork ());
+    if (process_id == -1)
+    {
+        ::close (pipe [0]);
+        return false;
+    }
+    if (process_id == 0)
+    {
+        // 'dup2 ()' clears 'FD_CLOEXEC' of the target, the sources are closed on 'exec'.
+        for (std::size_t i (0); i < sources.size (); ++i)
+        {
+            if (::dup2 (sources [i], first_descriptor + static_cast<int> (i)) == -1)
+                ::_exit (127);
+        }
+        auto value (static_cast<unsigned long> (::getpid ()));
+        char digits [20];
+        int size (0);
+        do
+        {
+            digits [size++] = static_cast<char> ('0' + value % 10);
+            value /= 10;
+        }
+        while (value != 0);
+        for (int i (0); i < size; ++i)
+            process_id_value [i] = digits [size - 1 - i];
+        // The mask is inherited through 'exec', and the signals handled here are blocked.
+        ::pthread_sigmask (SIG_SETMASK, & mask, nullptr);
+        ::execve (argv.front (), argv.data (), envp.data ());
+        ::_exit (127);
+    }
+
+    process_id_ = process_id;
+    descriptor = pipe [0];
+    notifier = new QSocketNotifier (descriptor, QSocketNotifier::Read, this);
+    connect (notifier, & QSocketNotifier::activated, this, & upgrade_process::process);
+    return true;
+}
+
+qint64 upgrade_process::process_id () const
+{
+    return process_id_;
+}
+
+QString upgrade_process::ready_name ()
+{
+    return QStringLiteral ("background_upgrade_ready");
+}
+
+QString upgrade_process::state_name ()
+{
+    return QStringLiteral ("background_upgrade_state");
+}
+
+void upgrade_process::report_ready (const qintptr descriptor)
+{
+    const char byte (1);
+    while (::write (static_cast<int> (descriptor), & byte, 1) == -1 and errno == EINTR);
+    ::close (static_cast<int> (descriptor));
+}
+
+QByteArray upgrade_process::read_state (const qintptr descriptor)
+{
+    QByteArray result;
+    char buffer [4096];
+    Q_FOREVER
+    {
+        const auto size (::read (static_cast<int> (descriptor), buffer, sizeof (buffer)));
+        if (size == -1 and errno == EINTR)
+            continue;
+        if (size <= 0)
+            break;
+        result.append (buffer, static_cast<int> (size));
+    }
+    ::close (static_cast<int> (descriptor));
+    return result;
+}
+
+void upgrade_process::process ()
+{
+    char byte (0);
+    const auto size (::read (descriptor, & byte, 1));
+    if (size == -1 and (errno == EINTR or errno == EAGAIN))
+        return;
+    delete notifier;
+    notifier = nullptr;
+    ::close (descriptor);
+    descriptor = -1;
+    const bool ready (size == 1);
+    // Exited, or is about to. Not left a zombie for as long as this process is serving.
+    if (not ready)
+    {
+        exiting.push_back (process_id_);
+        reap ();
+    }
+    Q_EMIT finished (ready);
+}
+
+void upgrade_process::reap ()
+{
+    exiting.erase (
+        std::remove_if (
+            exiting.begin (), exiting.end (),
+            [] (const qint64 process_id)
+            {
+                pid_t result;
+                while ((result = ::waitpid (static_cast<pid_t> (process_id), nullptr, WNOHANG)) == -1 and errno == EINTR);
+                // Kept while running. Otherwise reaped, or not a child of this process.
+                return result != 0;
+            }
+        ),
+        exiting.end ()
+    );
+    if (exiting.empty ())
+    {
+        if (reaper != nullptr)
+            reaper->stop ();
+        return;
+    }
+    if (reaper == nullptr)
+    {
+        reaper = new QTimer (this);
+        reaper->setInterval (std::chrono::milliseconds (100));
+        connect (reaper, & QTimer::timeout, this, & upgrade_process::reap);
+    }
+    if (not reaper->isActive ())
+        reaper->start ();
+}
+
+namespace
+{
+
+int duplicate (const int descriptor, const int lowest)
+{
+    return ::fcntl (descriptor, F_DUPFD_CLOEXEC, lowest);
+}
+
+// Lives in memory only, gone with the last descriptor.
+int create_state (const QByteArray & state)
+{
+    const auto descriptor (::memfd_create ("background_upgrade_state", MFD_CLOEXEC));
+    if (descriptor == -1)
+        return -1;
+    for (qsizetype written (0); written < state.size ();)
+    {
+        const auto size (::write (descriptor, state.constData () + written, static_cast<std::size_t> (state.size () - written)));
+        if (size == -1 and errno == EINTR)
+            continue;
+        if (size <= 0)
+        {
+            ::close (descriptor);
+            return -1;
+        }
+        written += size;
+    }
+    if (::lseek (descriptor, 0, SEEK_SET) == -1)
+    {
+        ::close (descriptor);
+        return -1;
+    }
+    return descriptor;
+}
+
+} // namespace
+
+} // namespace background
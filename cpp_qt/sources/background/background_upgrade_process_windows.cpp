@@ -0,0 +1,59 @@
+#include "background_upgrade_process.hpp"
+
+#include <windows.h>
+
+namespace background
+{
+
+upgrade_process::upgrade_process (QObject * const parent)
+    : QObject (parent),
+    process_id_ (-1),
+    descriptor (-1),
+    notifier (nullptr),
+    reaper (nullptr)
+{}
+
+upgrade_process::~upgrade_process ()
+{}
+
+// Sockets are not inherited on Windows the way descriptors are, it takes 'WSADuplicateSocket'
+// and a protocol both instances agree on. Not supported.
+bool upgrade_process::start (
+    const QString &, const QStringList &,
+    const std::vector<inherited_descriptor> &, const QByteArray &
+)
+{
+    ::SetLastError (ERROR_NOT_SUPPORTED);
+    return false;
+}
+
+qint64 upgrade_process::process_id () const
+{
+    return process_id_;
+}
+
+QString upgrade_process::ready_name ()
+{
+    return QStringLiteral ("background_upgrade_ready");
+}
+
+QString upgrade_process::state_name ()
+{
+    return QStringLiteral ("background_upgrade_state");
+}
+
+void upgrade_process::report_ready (qintptr)
+{}
+
+QByteArray upgrade_process::read_state (qintptr)
+{
+    return {};
+}
+
+void upgrade_process::process ()
+{}
+
+void upgrade_process::reap ()
+{}
+
+} // namespace background
@@ -0,0 +1,152 @@
+#include <functional>
+
+#include <QtTest/QTest>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QLoggingCategory>
+
+#include <background/application>
+
+#include "test_platforms.hpp"
+
+using namespace background;
+
+class benchmark_application : public QObject
+{
+    private Q_SLOTS:
+    void initTestCase ();
+
+    void running_to_serving ();
+    void shutting_down_to_stopped ();
+    void pausing_and_resuming ();
+    void receiving_event_burst ();
+
+    private:
+    Q_OBJECT
+};
+
+namespace
+{
+
+// Each iteration is a whole lifecycle, so that the set up is kept out of the measurement.
+constexpr int lifecycle_iterations (200);
+constexpr int burst_size (5000);
+
+bool process_events_until (const std::function<bool ()> & condition)
+{
+    QElapsedTimer elapsed;
+    elapsed.start ();
+    while (not condition ())
+    {
+        if (elapsed.hasExpired (5000))
+            return false;
+        QCoreApplication::processEvents ();
+    }
+    return true;
+}
+
+} // namespace
+
+void benchmark_application::initTestCase ()
+{
+    // Logging every event would be measured instead.
+    QLoggingCategory::setFilterRules (QStringLiteral ("background.*.info=false"));
+}
+
+void benchmark_application::running_to_serving ()
+{
+    qint64 total (0);
+    for (int i (0); i < lifecycle_iterations; ++i)
+    {
+        event_loop_controller_test event_loop;
+        console_platform_test console;
+        application application;
+        connect (& application, & application::start, & application, & application::set_started);
+        connect (& application, & application::stop, & application, & application::set_stopped);
+
+        QElapsedTimer elapsed;
+        elapsed.start ();
+        application.set_no_running_as_service ().run ();
+        QVERIFY (process_events_until ([& application] () { return application.state ().serving (); }));
+        total += elapsed.nsecsElapsed ();
+
+        application.shut_down ();
+        QVERIFY (process_events_until ([& application] () { return application.state ().stopped (); }));
+    }
+    QTest::setBenchmarkResult (static_cast<qreal> (total) / lifecycle_iterations, QTest::WalltimeNanoseconds);
+}
+
+void benchmark_application::shutting_down_to_stopped ()
+{
+    qint64 total (0);
+    for (int i (0); i < lifecycle_iterations; ++i)
+    {
+        event_loop_controller_test event_loop;
+        console_platform_test console;
+        application application;
+        connect (& application, & application::start, & application, & application::set_started);
+        connect (& application, & application::stop, & application, & application::set_stopped);
+
+        application.set_no_running_as_service ().run ();
+        QVERIFY (process_events_until ([& application] () { return application.state ().serving (); }));
+
+        QElapsedTimer elapsed;
+        elapsed.start ();
+        application.shut_down ();
+        QVERIFY (process_events_until ([& application] () { return application.state ().stopped (); }));
+        total += elapsed.nsecsElapsed ();
+    }
+    QTest::setBenchmarkResult (static_cast<qreal> (total) / lifecycle_iterations, QTest::WalltimeNanoseconds);
+}
+
+// Without handlers, each of pausing and resuming is a single queued hop through the event loop.
+void benchmark_application::pausing_and_resuming ()
+{
+    event_loop_controller_test event_loop;
+    console_platform_test console;
+    application application;
+    connect (& application, & application::start, & application, & application::set_started);
+    connect (& application, & application::stop, & application, & application::set_stopped);
+    application.set_no_running_as_service ().run ();
+    QVERIFY (process_events_until ([& application] () { return application.state ().serving (); }));
+
+    QBENCHMARK
+    {
+        application.pause ();
+        QVERIFY (process_events_until ([& application] () { return application.state ().paused (); }));
+        application.resume ();
+        QVERIFY (process_events_until ([& application] () { return application.state ().serving (); }));
+    }
+
+    application.shut_down ();
+    QVERIFY (process_events_until ([& application] () { return application.state ().stopped (); }));
+}
+
+// The system events are handled before anything else, so the burst is through once pausing is done.
+void benchmark_application::receiving_event_burst ()
+{
+    event_loop_controller_test event_loop;
+    console_platform_test console;
+    application application;
+    connect (& application, & application::start, & application, & application::set_started);
+    connect (& application, & application::stop, & application, & application::set_stopped);
+    application.set_no_running_as_service ().run ();
+    QVERIFY (process_events_until ([& application] () { return application.state ().serving (); }));
+
+    QBENCHMARK
+    {
+        for (int i (0); i < burst_size; ++i)
+            Q_EMIT console.event_received (application_system_event { application_system_event::memory_pressure_some, QStringLiteral ("benchmark") });
+        application.pause ();
+        QVERIFY (process_events_until ([& application] () { return application.state ().paused (); }));
+        application.resume ();
+        QVERIFY (process_events_until ([& application] () { return application.state ().serving (); }));
+    }
+    qInfo ("Events in a burst: '%d', the most queued: '%llu'.", burst_size, static_cast<unsigned long long> (application.metrics ().system_events_high_water_mark.load ()));
+
+    application.shut_down ();
+    QVERIFY (process_events_until ([& application] () { return application.state ().stopped (); }));
+}
+
+QTEST_MAIN (benchmark_application)
+
+#include "benchmark_application.moc"
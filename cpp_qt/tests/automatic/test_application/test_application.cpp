@@ -1,18 +1,34 @@
 #include <vector>
+#include <atomic>
+#include <cstring>
+#include <stdexcept>
 
 //#include <QtTest/QtTest>
 #include <QtTest/QTest>
 #include <QtTest/QSignalSpy>
-#if not defined QT_STATICPLUGIN
-#define QT_STATICPLUGIN
-#endif
-#include <QtCore/QPluginLoader>
+#include <QtCore/QTemporaryDir>
+#include <QtCore/QFile>
+#include <QtCore/QTimer>
+#include <QtCore/QProcess>
+#include <QtCore/QThread>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QJsonObject>
+#include <QtCore/QJsonArray>
 
 #include <background/application>
 #include <background/background_event_loop_controller.hpp>
 #include <background/background_service_platform.hpp>
 #include <background/background_console_platform.hpp>
 
+#include "test_platforms.hpp"
+
+#if defined Q_OS_LINUX
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
 using namespace background;
 
 class test_application : public QObject
@@ -50,6 +66,36 @@ class test_application : public QObject
     void receiving_event_while_proceeding_reenters ();
 
     void system_events_logged_while_stopping ();
+    void receiving_reload_event_reloads_while_serving ();
+    void pausing_and_resuming_keeps_serving ();
+    void receiving_memory_pressure_event_notifies_while_serving ();
+    void system_events_dropped_while_full ();
+    void stop_event_replaces_latest_while_full ();
+    void pausing_and_resuming_coalesce_only_with_latest_event ();
+    void cpu_budget_bounded_by_processors ();
+    void tracing_records_lifecycle ();
+    void metrics_count_lifecycle ();
+    void proceeding_synchronously_takes_fewer_iterations ();
+    void exporting_lifecycle_graph ();
+    void running_tasks_on_thread_pool ();
+    void stopping_while_start_task_runs_cancels_it ();
+    void throwing_start_task_fails_to_start ();
+    void throwing_stop_task_stops ();
+    void running_as_systemd_service_notifies_service_manager ();
+    void running_without_notify_socket_fails_to_run ();
+    void receiving_posix_signal_stops_console_application ();
+    void receiving_posix_signals_pauses_and_resumes_console_application ();
+    void upgrading_to_failing_instance_keeps_serving ();
+    void upgrading_passes_descriptors_and_state ();
+    void running_as_systemd_service_keeps_watchdog_alive ();
+    void stalled_event_loop_withholds_watchdog_keepalive ();
+    void stalled_event_loop_withholds_watchdog_keepalive_by_default ();
+    void running_as_systemd_service_stores_descriptors ();
+    void inheriting_socket_activated_descriptors ();
+    void exiting_fast_runs_flushes ();
+    void exiting_fast_with_hanging_flush_times_out ();
+    void reporting_progress_extends_service_timeout ();
+    void running_as_systemd_service_notifies_reloading ();
 
     void destroying_incorrectly_does_not_crash_1 ();
 
@@ -57,115 +103,35 @@ class test_application : public QObject
     Q_OBJECT
 };
 
-class event_loop_controller_test : public event_loop_controller
-{
-    public :
-    event_loop_controller_test ();
-    ~event_loop_controller_test ();
-
-    QSignalSpy exited;
-
-    public Q_SLOTS :
-    void exit (int exit_code) override;
-
-    Q_SIGNALS :
-    void exit_ (int exit_code);
-
-    private :
-    Q_OBJECT
-};
-
-class service_platform_test : public service_platform
-{
-    public :
-    service_platform_test ();
-    ~service_platform_test ();
-
-    QSignalSpy checked;
-
-    QSignalSpy started_;
-    QSignalSpy stopped_;
-
-    QSignalSpy state_serving_set_;
-    QSignalSpy state_stopping_set_;
-    QSignalSpy state_stopped_set_;
-
-    QSignalSpy configuration_retrieved_;
-
-    public Q_SLOTS :
-    bool check () override;
-
-    void start () override;
-    void stop () override;
-
-    void set_state_serving () override;
-    void set_state_stopping () override;
-    void set_state_stopped (int exit_code) override;
-
-    void retrieve_configuration () override;
-
-    Q_SIGNALS :
-    bool check_ ();
-
-    void start_ ();
-    void stop_ ();
-
-    void set_state_serving_ ();
-    void set_state_stopping_ ();
-    void set_state_stopped_ (int exit_code);
-
-    void retrieve_configuration_ ();
-
-    public Q_SLOTS :
-    void send_stop ();
-
-    private :
-    Q_OBJECT
-};
-
-class console_platform_test : public console_platform
+// A stand-in for the service manager socket set in 'NOTIFY_SOCKET'.
+struct notify_socket_test
 {
-    public :
-    console_platform_test ();
-    ~console_platform_test ();
-
-    QSignalSpy started_;
-    QSignalSpy stopped_;
-
-    public Q_SLOTS :
-    void start () override;
-    void stop () override;
+    notify_socket_test ();
+    ~notify_socket_test ();
 
-    Q_SIGNALS :
-    void start_ ();
-    void stop_ ();
+    bool open ();
+    QByteArrayList receive ();
 
-    public Q_SLOTS :
-    void send_stop ();
-
-    private :
-    Q_OBJECT
+    QTemporaryDir directory;
+    int socket;
+    // Passed along with the messages.
+    std::vector<int> descriptors;
 };
 
-struct serving_state_changes
+// Collects the messages logged while it exists, passing them on.
+struct logged_messages
 {
-    serving_state_changes (application * application);
-
-    bool wait (service_state value);
-
-    application * const application_;
-    std::vector<serving_state> changes;
-    std::optional<QSignalSpy> changed;
+    logged_messages ();
+    ~logged_messages ();
 
-    static std::vector<serving_state> none_to_stopped ();
-    static std::vector<serving_state> serving_to_stopped ();
-    static std::vector<serving_state> serving_stopping_to_stopped ();
+    static QStringList messages;
+    static QtMessageHandler previous;
 };
 
-struct signal_utility : QObject
-{
-    static bool connected (const QObject * object, const QSignalSpy & signal);
-};
+// Emits the events at once, once serving.
+void send_system_events_while_serving (
+    application & application, console_platform_test & console, const std::vector<application_system_event> & events
+);
 
 void test_application::setting_failed_to_start_shuts_down ()
 {
@@ -958,324 +924,1182 @@ void test_application::system_events_logged_while_stopping ()
     console_ = nullptr;
 }
 
-void test_application::destroying_incorrectly_does_not_crash_1 ()
+void test_application::receiving_reload_event_reloads_while_serving ()
 {
-    #if not defined NDEBUG
-    QSKIP ("Expected to abort.");
-    #endif
-
     event_loop_controller_test event_loop;
-    service_platform_test service;
-    application * application (new class application);
-
-    application->run ();
+    console_platform_test console;
+    application application;
+    serving_state_changes state_changed (& application);
+    int reloaded (0);
 
+    connect (& application, & application::start, & application, & application::set_started);
+    connect (& application, & application::stop, & application, & application::set_stopped);
     connect (
-        application,
-        & application::start,
-        application,
-        [application] ()
+        & application,
+        & application::reload,
+        & application,
+        [& application, & console, & reloaded] ()
         {
-            delete application;
+            QCOMPARE (application.state ().state, service_state::serving);
+            reloaded += 1;
+            // Requested again while reloading: reloads once more.
+            if (reloaded == 1)
+                Q_EMIT console.event_received (application_system_event { application_system_event::reload, QStringLiteral ("test") });
+            application.set_reloaded ();
+            if (reloaded == 2)
+                application.shut_down ();
         }
     );
-}
+    connect (
+        & application,
+        & application::state_changed,
+        & application,
+        [& application, & console] ()
+        {
+            if (not application.state ().serving ())
+                return;
+            Q_EMIT console.event_received (application_system_event { application_system_event::reload, QStringLiteral ("test") });
+        }
+    );
+    application.set_no_running_as_service ().run ();
 
-template <class T> T * plugin ()
-{
-    const auto plugins (QPluginLoader::staticPlugins ());
-    for (const auto & plugin : plugins)
-    {
-        if (plugin.instance ()->metaObject () != & T::staticMetaObject)
-            continue;
-        return reinterpret_cast <T *> (plugin.instance ());
-    }
-    return nullptr;
+    QVERIFY (state_changed.wait (service_state::stopped));
+    QCOMPARE (reloaded, 2);
+    QCOMPARE (state_changed.changes, serving_state_changes::serving_to_stopped ());
 }
 
-class event_loop_controller_plugin_test : public event_loop_controller_plugin
+void test_application::pausing_and_resuming_keeps_serving ()
 {
-    public :
-    event_loop_controller_plugin_test (QObject * parent = nullptr);
-
-    public :
-    event_loop_controller * create (QObject * parent) override;
-
-    private :
-    event_loop_controller * controller = nullptr;
-    friend class event_loop_controller_test;
-
-    private :
-    Q_OBJECT
-    Q_PLUGIN_METADATA (IID "background.event_loop_controller_plugin")
-    Q_INTERFACES (background::event_loop_controller_plugin)
-};
-
-Q_IMPORT_PLUGIN (event_loop_controller_plugin_test)
+    event_loop_controller_test event_loop;
+    console_platform_test console;
+    application application;
+    QSignalSpy stop (& application, & application::stop);
+    serving_state_changes state_changed (& application);
 
-event_loop_controller_plugin_test::event_loop_controller_plugin_test (QObject * const parent)
-    : event_loop_controller_plugin (parent)
-{}
+    connect (& application, & application::start, & application, & application::set_started);
+    connect (& application, & application::stop, & application, & application::set_stopped);
+    connect (
+        & application,
+        & application::pause_serving,
+        & application,
+        [& application] ()
+        {
+            QCOMPARE (application.state ().state, service_state::pausing);
+            application.set_paused ();
+        }
+    );
+    connect (
+        & application,
+        & application::resume_serving,
+        & application,
+        [& application] ()
+        {
+            QCOMPARE (application.state ().state, service_state::resuming);
+            application.set_resumed ();
+        }
+    );
+    connect (
+        & application,
+        & application::state_changed,
+        & application,
+        [& application, & state_changed] ()
+        {
+            if (application.state ().paused ())
+                application.resume ();
+            else if (application.state ().serving () and state_changed.changes.size () == 1)
+                application.pause ();
+            else if (application.state ().serving ())
+                application.shut_down ();
+        }
+    );
+    application.set_no_running_as_service ().run ();
 
-event_loop_controller * event_loop_controller_plugin_test::create (QObject * const parent)
-{
-    Q_UNUSED (parent)
-    return controller;
+    QVERIFY (state_changed.wait (service_state::stopped));
+    QCOMPARE (stop.count (), 1);
+    QCOMPARE (
+        state_changed.changes,
+        std::vector<serving_state> (
+            {
+                { service_state::serving, target_service_state::none },
+                { service_state::paused, target_service_state::none },
+                { service_state::serving, target_service_state::none },
+                { service_state::stopped, target_service_state::none }
+            }
+        )
+    );
 }
 
-event_loop_controller_test::event_loop_controller_test ()
-    : event_loop_controller (nullptr),
-    exited (this, & event_loop_controller_test::exit_)
+void test_application::receiving_memory_pressure_event_notifies_while_serving ()
 {
-    plugin<event_loop_controller_plugin_test> ()->controller = this;
-}
+    event_loop_controller_test event_loop;
+    console_platform_test console;
+    application application;
+    QSignalSpy memory_pressure (& application, & application::memory_pressure);
+    serving_state_changes state_changed (& application);
 
-event_loop_controller_test::~event_loop_controller_test ()
-{
-    plugin<event_loop_controller_plugin_test> ()->controller = nullptr;
-}
+    connect (& application, & application::start, & application, & application::set_started);
+    connect (& application, & application::stop, & application, & application::set_stopped);
+    connect (
+        & application,
+        & application::memory_pressure,
+        & application,
+        [& application, & console] (const bool full)
+        {
+            if (not full)
+                return;
+            // Not delivered once stopping.
+            application.shut_down ();
+            Q_EMIT console.event_received (application_system_event { application_system_event::memory_pressure_full, QStringLiteral ("test") });
+        }
+    );
+    connect (
+        & application,
+        & application::state_changed,
+        & application,
+        [& application, & console] ()
+        {
+            if (not application.state ().serving ())
+                return;
+            Q_EMIT console.event_received (application_system_event { application_system_event::memory_pressure_some, QStringLiteral ("test") });
+            Q_EMIT console.event_received (application_system_event { application_system_event::memory_pressure_full, QStringLiteral ("test") });
+        }
+    );
+    application.set_no_running_as_service ().run ();
 
-void event_loop_controller_test::exit (const int exit_code)
-{
-    Q_EMIT exit_ (exit_code);
+    QVERIFY (state_changed.wait (service_state::stopped));
+    QCOMPARE (memory_pressure.count (), 2);
+    QCOMPARE (memory_pressure.at (0).at (0).toBool (), false);
+    QCOMPARE (memory_pressure.at (1).at (0).toBool (), true);
+    QCOMPARE (state_changed.changes, serving_state_changes::serving_to_stopped ());
 }
 
-class service_platform_plugin_test : public service_platform_plugin
+void test_application::system_events_dropped_while_full ()
 {
-    public :
-    service_platform_plugin_test (QObject * parent = nullptr);
-
-    public :
-    unsigned int order () const override;
-    bool detect () override;
-    service_platform * create (QObject * parent) override;
+    event_loop_controller_test event_loop;
+    console_platform_test console;
+    application application;
+    serving_state_changes state_changed (& application);
+    const logged_messages logged;
 
-    private :
-    service_platform * service = nullptr;
-    friend class service_platform_test;
+    // Pausing and resuming by turns are all queued.
+    std::vector<application_system_event> events;
+    for (int i (0); i < 32; ++i)
+    {
+        const auto action (i % 2 == 0 ? application_system_event::pause : application_system_event::resume);
+        events.push_back ({ action, QString::number (i) });
+    }
+    events.push_back ({ application_system_event::reload, QStringLiteral ("dropped") });
+    events.push_back ({ application_system_event::memory_pressure_some, QStringLiteral ("dropped") });
+    send_system_events_while_serving (application, console, events);
 
-    private :
-    Q_OBJECT
-    Q_PLUGIN_METADATA (IID "background.service_platform_plugin")
-    Q_INTERFACES (background::service_platform_plugin)
-};
+    // Shutting down meanwhile would have the pausing and resuming ignored.
+    QTRY_VERIFY (logged.messages.contains (QStringLiteral ("Resume on signal: '31'.")));
+    application.shut_down ();
+    QVERIFY (state_changed.wait (service_state::stopped));
+    const auto & metrics (application.metrics ());
+    QCOMPARE (metrics.system_events.load (), std::uint64_t (34));
+    QCOMPARE (metrics.system_events_high_water_mark.load (), std::uint64_t (32));
+    QCOMPARE (metrics.system_events_coalesced.load (), std::uint64_t (0));
+    QCOMPARE (metrics.system_events_dropped.load (), std::uint64_t (2));
+    QVERIFY (not logged.messages.contains (QStringLiteral ("Reload on signal: 'dropped'.")));
+    QVERIFY (not logged.messages.contains (QStringLiteral ("Memory pressure: 'some'.")));
+}
 
-Q_IMPORT_PLUGIN (service_platform_plugin_test)
+void test_application::stop_event_replaces_latest_while_full ()
+{
+    event_loop_controller_test event_loop;
+    console_platform_test console;
+    application application;
+    serving_state_changes state_changed (& application);
+    const logged_messages logged;
 
-service_platform_plugin_test::service_platform_plugin_test (QObject * const parent)
-    : service_platform_plugin (parent)
-{}
+    std::vector<application_system_event> events;
+    for (int i (0); i < 32; ++i)
+    {
+        const auto action (i % 2 == 0 ? application_system_event::pause : application_system_event::resume);
+        events.push_back ({ action, QString::number (i) });
+    }
+    events.push_back ({ application_system_event::stop, QStringLiteral ("stop") });
+    send_system_events_while_serving (application, console, events);
 
-unsigned int service_platform_plugin_test::order () const
-{
-    return 1;
+    QVERIFY (state_changed.wait (service_state::stopped));
+    const auto & metrics (application.metrics ());
+    QCOMPARE (metrics.system_events_high_water_mark.load (), std::uint64_t (32));
+    QCOMPARE (metrics.system_events_dropped.load (), std::uint64_t (0));
+    QVERIFY (logged.messages.contains (QStringLiteral ("Pause on signal: '30'.")));
+    QVERIFY (not logged.messages.contains (QStringLiteral ("Resume on signal: '31'.")));
+    QVERIFY (logged.messages.contains (QStringLiteral ("Stop on signal: 'stop'.")));
+    QCOMPARE (state_changed.changes, serving_state_changes::serving_to_stopped ());
 }
 
-bool service_platform_plugin_test::detect ()
+void test_application::pausing_and_resuming_coalesce_only_with_latest_event ()
 {
-    return service != nullptr;
-}
+    event_loop_controller_test event_loop;
+    console_platform_test console;
+    application application;
+    serving_state_changes state_changed (& application);
+    const logged_messages logged;
 
-service_platform * service_platform_plugin_test::create (QObject * const parent)
-{
-    Q_UNUSED (parent)
-    return service;
-}
+    send_system_events_while_serving (
+        application, console,
+        {
+            { application_system_event::pause, QStringLiteral ("1") },
+            { application_system_event::resume, QStringLiteral ("2") },
+            { application_system_event::pause, QStringLiteral ("3") },
+            // Coalesced with the latest.
+            { application_system_event::pause, QStringLiteral ("4") },
+            { application_system_event::stop, QStringLiteral ("5") }
+        }
+    );
 
-service_platform_test::service_platform_test ()
-    : service_platform (nullptr),
-    checked (this, & service_platform_test::check_),
-    started_ (this, & service_platform_test::start_),
-    stopped_ (this, & service_platform_test::stop_),
-    state_serving_set_ (this, & service_platform_test::set_state_serving_),
-    state_stopping_set_ (this, & service_platform_test::set_state_stopping_),
-    state_stopped_set_ (this, & service_platform_test::set_state_stopped_),
-    configuration_retrieved_ (this, & service_platform_test::retrieve_configuration_)
-{
-    plugin<service_platform_plugin_test> ()->service = this;
+    QVERIFY (state_changed.wait (service_state::stopped));
+    const auto & metrics (application.metrics ());
+    QCOMPARE (metrics.system_events_high_water_mark.load (), std::uint64_t (4));
+    QCOMPARE (metrics.system_events_coalesced.load (), std::uint64_t (1));
+    QStringList handled;
+    for (const auto & message : logged.messages)
+    {
+        if (message.contains (QStringLiteral (" on signal: '")))
+            handled.append (message);
+    }
+    QCOMPARE (
+        handled,
+        QStringList (
+            {
+                QStringLiteral ("Pause on signal: '1'."),
+                QStringLiteral ("Resume on signal: '2'."),
+                QStringLiteral ("Pause on signal: '3'."),
+                QStringLiteral ("Stop on signal: '5'.")
+            }
+        )
+    );
 }
 
-service_platform_test::~service_platform_test ()
+void test_application::cpu_budget_bounded_by_processors ()
 {
-    plugin<service_platform_plugin_test> ()->service = nullptr;
-}
+    application application;
 
-bool service_platform_test::check ()
-{
-    const bool result (Q_EMIT check_ ());
-    if (not signal_utility::connected (this, checked))
-        return true;
-    return result;
+    QVERIFY (application.cpu_budget () > 0);
+    QVERIFY (application.cpu_budget () <= QThread::idealThreadCount ());
+    QVERIFY (application.ideal_thread_count () >= 1);
+    QVERIFY (application.ideal_thread_count () <= QThread::idealThreadCount ());
 }
 
-void service_platform_test::start ()
+void test_application::tracing_records_lifecycle ()
 {
-    Q_EMIT start_ ();
-    if (not signal_utility::connected (this, started_))
-        Q_EMIT started ();
-}
+    event_loop_controller_test event_loop;
+    console_platform_test console;
+    application application;
+    serving_state_changes state_changed (& application);
 
-void service_platform_test::stop ()
-{
-    Q_EMIT stop_ ();
-    if (not signal_utility::connected (this, stopped_))
-        Q_EMIT stopped ();
-}
+    connect (& application, & application::start, & application, & application::set_started);
+    connect (& application, & application::stop, & application, & application::set_stopped);
+    connect (
+        & application,
+        & application::state_changed,
+        & application,
+        [& application] ()
+        {
+            if (application.state ().serving ())
+                application.shut_down ();
+        }
+    );
+    application.set_no_running_as_service ().run ();
 
-void service_platform_test::set_state_serving ()
-{
-    Q_EMIT set_state_serving_ ();
-    if (not signal_utility::connected (this, state_serving_set_))
-        Q_EMIT state_serving_set ();
+    QVERIFY (state_changed.wait (service_state::stopped));
+    const auto document (QJsonDocument::fromJson (application.trace ()));
+    QVERIFY (document.isObject ());
+    QStringList names;
+    for (const auto & event : document.object ().value (QStringLiteral ("traceEvents")).toArray ())
+        names.append (event.toObject ().value (QStringLiteral ("name")).toString ());
+    QVERIFY (names.contains (QStringLiteral ("start_console_platform")));
+    QVERIFY (names.contains (QStringLiteral ("start ()")));
+    QVERIFY (names.contains (QStringLiteral ("console_platform_started")));
+    QVERIFY (names.contains (QStringLiteral ("stop_serving")));
+    QVERIFY (names.contains (QStringLiteral ("stop ()")));
 }
 
-void service_platform_test::set_state_stopping ()
+void test_application::metrics_count_lifecycle ()
 {
-    Q_EMIT set_state_stopping_ ();
-    if (not signal_utility::connected (this, state_stopping_set_))
-        Q_EMIT state_stopping_set ();
-}
+    event_loop_controller_test event_loop;
+    console_platform_test console;
+    application application;
+    serving_state_changes state_changed (& application);
 
-void service_platform_test::set_state_stopped (const int exit_code)
-{
-    Q_EMIT set_state_stopped_ (exit_code);
-    if (not signal_utility::connected (this, state_stopped_set_))
-        Q_EMIT state_stopped_set ();
+    connect (& application, & application::start, & application, & application::set_started);
+    connect (& application, & application::stop, & application, & application::set_stopped);
+    connect (
+        & application,
+        & application::state_changed,
+        & application,
+        [& application, & console] ()
+        {
+            if (not application.state ().serving ())
+                return;
+            Q_EMIT console.event_received (application_system_event { application_system_event::stop, QStringLiteral ("test") });
+            Q_EMIT console.event_received (application_system_event { application_system_event::stop, QStringLiteral ("test") });
+        }
+    );
+    application.set_no_running_as_service ().run ();
+
+    QVERIFY (state_changed.wait (service_state::stopped));
+    const auto & metrics (application.metrics ());
+    QVERIFY (metrics.proceed_iterations.load () > 0);
+    QVERIFY (metrics.proceed_posted.load () > 0);
+    QCOMPARE (metrics.system_events.load (), std::uint64_t (2));
+    QCOMPARE (metrics.system_events_high_water_mark.load (), std::uint64_t (1));
+    QCOMPARE (metrics.system_events_coalesced.load (), std::uint64_t (1));
+    QCOMPARE (metrics.stop_latency.count (), std::uint64_t (1));
+    QCOMPARE (metrics.state_durations [static_cast<std::size_t> (service_state::starting)].count (), std::uint64_t (1));
+    QCOMPARE (metrics.state_durations [static_cast<std::size_t> (service_state::serving)].count (), std::uint64_t (1));
 }
 
-void service_platform_test::retrieve_configuration ()
+void test_application::proceeding_synchronously_takes_fewer_iterations ()
 {
-    Q_EMIT retrieve_configuration_ ();
-    if (not signal_utility::connected (this, configuration_retrieved_))
-        Q_EMIT configuration_retrieved (
-            service_configuration
+    // The times the event loop went around for proceeding.
+    const auto posted = [] (const bool synchronously) -> std::uint64_t
+    {
+        event_loop_controller_test event_loop;
+        console_platform_test console;
+        application application;
+        serving_state_changes state_changed (& application);
+
+        connect (& application, & application::start, & application, & application::set_started);
+        connect (& application, & application::stop, & application, & application::set_stopped);
+        connect (
+            & application,
+            & application::state_changed,
+            & application,
+            [& application] ()
             {
-                QStringLiteral ("test_service"),
-                QStringLiteral ("Test Service."),
-                QStringLiteral ("test_service"),
-                QStringLiteral ("test"),
+                if (application.state ().serving ())
+                    application.shut_down ();
             }
         );
+        if (synchronously)
+            application.set_with_synchronous_proceeding ();
+        application.set_no_running_as_service ().run ();
+
+        if (not state_changed.wait (service_state::stopped))
+            return 0;
+        const auto & metrics (application.metrics ());
+        return metrics.proceed_posted.load () - metrics.control_retaken.load ();
+    };
+    const auto through_event_loop (posted (false));
+    const auto synchronously (posted (true));
+    QVERIFY (through_event_loop > 0);
+    QVERIFY (synchronously > 0);
+    QVERIFY (synchronously < through_event_loop);
 }
 
-void service_platform_test::send_stop ()
+void test_application::exporting_lifecycle_graph ()
 {
-    Q_EMIT event_received (application_system_event { application_system_event::stop, QStringLiteral ("test") });
+    const auto graph (application::lifecycle_graph ());
+    QVERIFY (graph.startsWith (QStringLiteral ("digraph lifecycle")));
+    QVERIFY (graph.contains (QStringLiteral ("\"starting.set_state_serving\" -> \"starting.done\"")));
+    QVERIFY (graph.contains (QStringLiteral ("\"stopping.stop_serving\" -> \"stopping.stop_service_platform\" [label=\"upgraded service\"]")));
+    QVERIFY (graph.contains (QStringLiteral ("\"reloading.reload_again\" -> \"reloading.requested\" [label=\"reloaded\"]")));
+    QVERIFY (graph.contains (QStringLiteral ("\"pausing.set_state_paused\" -> \"pausing.none\"")));
 }
 
-class console_platform_plugin_test : public console_platform_plugin
+void test_application::running_tasks_on_thread_pool ()
 {
-    public :
-    console_platform_plugin_test (QObject * parent = nullptr);
-
-    public :
-    unsigned int order () const override;
-    console_platform * create (QObject * parent) override;
-
-    private :
-    console_platform * console = nullptr;
-    friend class console_platform_test;
-
-    private :
-    Q_OBJECT
-    Q_PLUGIN_METADATA (IID "background.console_platform_plugin")
-    Q_INTERFACES (background::console_platform_plugin)
-};
-
-Q_IMPORT_PLUGIN (console_platform_plugin_test)
-
-console_platform_plugin_test::console_platform_plugin_test (QObject * const parent)
-    : console_platform_plugin (parent)
-{}
+    event_loop_controller_test event_loop;
+    console_platform_test console;
+    application application;
+    serving_state_changes state_changed (& application);
+    QThread * const main (QThread::currentThread ());
+    std::atomic<QThread *> start_thread (nullptr);
+    std::atomic<QThread *> stop_thread (nullptr);
 
-unsigned int console_platform_plugin_test::order () const
-{
-    return 1;
-}
+    application
+    .set_start_task (
+        [& start_thread] ()
+        {
+            start_thread = QThread::currentThread ();
+            return true;
+        }
+    )
+    .set_stop_task ([& stop_thread] () { stop_thread = QThread::currentThread (); })
+    .set_no_running_as_service ()
+    .run ();
 
-console_platform * console_platform_plugin_test::create (QObject * const parent)
-{
-    Q_UNUSED (parent)
-    return console;
+    QVERIFY (state_changed.wait (service_state::serving));
+    QVERIFY (application.start_task_future ().isFinished ());
+    QVERIFY (start_thread.load () != nullptr and start_thread.load () != main);
+    application.shut_down ();
+    QVERIFY (state_changed.wait (service_state::stopped));
+    QVERIFY (stop_thread.load () != nullptr and stop_thread.load () != main);
+    QCOMPARE (state_changed.changes, serving_state_changes::serving_to_stopped ());
 }
 
-console_platform_test::console_platform_test ()
-    : console_platform (nullptr),
-    started_ (this, & console_platform_test::start_),
-    stopped_ (this, & console_platform_test::stop_)
+void test_application::stopping_while_start_task_runs_cancels_it ()
 {
-    plugin<console_platform_plugin_test> ()->console = this;
-}
+    event_loop_controller_test event_loop;
+    console_platform_test console;
+    application application;
+    serving_state_changes state_changed (& application);
+    std::atomic<bool> running (false);
+    std::atomic<bool> canceled (false);
+
+    application
+    .set_start_task (
+        [& application, & running, & canceled] ()
+        {
+            running = true;
+            const auto future (application.start_task_future ());
+            while (not future.isCanceled ())
+                QThread::msleep (1);
+            canceled = true;
+            return true;
+        }
+    )
+    .set_with_stop_starting ()
+    .set_no_running_as_service ()
+    .run ();
 
-console_platform_test::~console_platform_test ()
+    QTRY_VERIFY (running.load ());
+    application.shut_down ();
+    QVERIFY (state_changed.wait (service_state::stopped));
+    QVERIFY (canceled.load ());
+    QCOMPARE (state_changed.changes, serving_state_changes::none_to_stopped ());
+}
+
+void test_application::throwing_start_task_fails_to_start ()
 {
-    plugin<console_platform_plugin_test> ()->console = nullptr;
+    event_loop_controller_test event_loop;
+    console_platform_test console;
+    application application;
+    serving_state_changes state_changed (& application);
+
+    application
+    .set_start_task ([] () -> bool { throw std::runtime_error ("test"); })
+    .set_no_running_as_service ()
+    .run ();
+
+    QVERIFY (state_changed.wait (service_state::stopped));
+    QCOMPARE (state_changed.changes, serving_state_changes::none_to_stopped ());
 }
 
-void console_platform_test::start ()
+void test_application::throwing_stop_task_stops ()
 {
-    Q_EMIT start_ ();
-    if (not signal_utility::connected (this, started_))
-        Q_EMIT started ();
+    event_loop_controller_test event_loop;
+    console_platform_test console;
+    application application;
+    serving_state_changes state_changed (& application);
+
+    application
+    .set_start_task ([] () { return true; })
+    .set_stop_task ([] () { throw std::runtime_error ("test"); })
+    .set_no_running_as_service ()
+    .run ();
+
+    QVERIFY (state_changed.wait (service_state::serving));
+    application.shut_down ();
+    QVERIFY (state_changed.wait (service_state::stopped));
+    QCOMPARE (state_changed.changes, serving_state_changes::serving_to_stopped ());
 }
 
-void console_platform_test::stop ()
+void test_application::running_as_systemd_service_notifies_service_manager ()
 {
-    Q_EMIT stop_ ();
-    if (not signal_utility::connected (this, stopped_))
-        Q_EMIT stopped ();
+    #if not defined Q_OS_LINUX
+    QSKIP ("The service manager protocol is specific to Linux.");
+    #else
+    notify_socket_test notify_socket;
+    QVERIFY (notify_socket.open ());
+
+    event_loop_controller_test event_loop;
+    application application;
+    serving_state_changes state_changed (& application);
+
+    connect (& application, & application::start, & application, & application::set_started);
+    connect (& application, & application::stop, & application, & application::set_stopped);
+    connect (
+        & application,
+        & application::state_changed,
+        & application,
+        [& application] ()
+        {
+            if (not application.state ().serving ())
+                return;
+            application.shut_down ();
+        }
+    );
+    application.set_exit_code (7);
+    application.set_no_retrieving_service_configuration ().run ();
+
+    QVERIFY (state_changed.wait (service_state::stopped));
+    QVERIFY (application.running_as_service ().has_value ());
+    QCOMPARE (application.running_as_service ().value (), true);
+    QCOMPARE (state_changed.changes, serving_state_changes::serving_to_stopped ());
+    QCOMPARE (
+        notify_socket.receive (),
+        QByteArrayList ({ QByteArrayLiteral ("READY=1"), QByteArrayLiteral ("STOPPING=1"), QByteArrayLiteral ("EXIT_STATUS=7") })
+    );
+    #endif
 }
 
-void console_platform_test::send_stop ()
+// Not spawned by the service manager: there is no service platform, as on any platform without one.
+void test_application::running_without_notify_socket_fails_to_run ()
 {
-    Q_EMIT event_received (application_system_event { application_system_event::stop, QStringLiteral ("test") });
+    #if not defined Q_OS_LINUX
+    QSKIP ("The service manager protocol is specific to Linux.");
+    #else
+    qunsetenv ("NOTIFY_SOCKET");
+
+    event_loop_controller_test event_loop;
+    application application;
+    QSignalSpy start (& application, & application::start);
+    serving_state_changes state_changed (& application);
+    QSignalSpy failed (& application, & application::failed);
+
+    application.run ();
+
+    state_changed.wait (service_state::stopped);
+    QVERIFY (start.isEmpty ());
+    QVERIFY (not failed.isEmpty ());
+    QVERIFY (application.error ().has_value ());
+    QCOMPARE (application.error ()->error, application_error::failed_to_run);
+    #endif
 }
 
-serving_state_changes::serving_state_changes (application * const application)
-    : changed (std::nullopt),
-    application_ (application)
+void test_application::running_as_systemd_service_keeps_watchdog_alive ()
 {
-    QObject::connect (
-        application,
+    #if not defined Q_OS_LINUX
+    QSKIP ("The service manager protocol is specific to Linux.");
+    #else
+    notify_socket_test notify_socket;
+    QVERIFY (notify_socket.open ());
+    qputenv ("WATCHDOG_USEC", QByteArrayLiteral ("100000"));
+
+    event_loop_controller_test event_loop;
+    application application;
+    serving_state_changes state_changed (& application);
+
+    connect (& application, & application::start, & application, & application::set_started);
+    connect (& application, & application::stop, & application, & application::set_stopped);
+    connect (
+        & application,
         & application::state_changed,
-        application,
-        [this, application] ()
+        & application,
+        [& application] ()
         {
-            changes.push_back (application->state ());
+            if (not application.state ().serving ())
+                return;
+            QTimer::singleShot (std::chrono::milliseconds (300), & application, & application::shut_down);
         }
     );
+    application.set_no_retrieving_service_configuration ().run ();
+
+    QVERIFY (state_changed.wait (service_state::stopped));
+    const auto messages (notify_socket.receive ());
+    QVERIFY (messages.count (QByteArrayLiteral ("WATCHDOG=1")) >= 3);
+    QCOMPARE (messages.first (), QByteArrayLiteral ("READY=1"));
+    #endif
 }
 
-bool serving_state_changes::wait (service_state value)
+void test_application::stalled_event_loop_withholds_watchdog_keepalive ()
 {
-    if (not changed.has_value ())
-        changed.emplace (application_, & application::state_changed);
-    do
+    #if not defined Q_OS_LINUX
+    QSKIP ("The service manager protocol is specific to Linux.");
+    #else
+    notify_socket_test notify_socket;
+    QVERIFY (notify_socket.open ());
+    qputenv ("WATCHDOG_USEC", QByteArrayLiteral ("100000"));
+
+    event_loop_controller_test event_loop;
+    application application;
+    serving_state_changes state_changed (& application);
+
+    connect (& application, & application::start, & application, & application::set_started);
+    connect (& application, & application::stop, & application, & application::set_stopped);
+    connect (
+        & application,
+        & application::state_changed,
+        & application,
+        [& application] ()
+        {
+            if (not application.state ().serving ())
+                return;
+            // The keepalive due in 50 ms comes out 150 ms late.
+            QThread::msleep (200);
+            QTimer::singleShot (std::chrono::milliseconds (20), & application, & application::shut_down);
+        }
+    );
+    application.set_watchdog_tolerance (0.25).set_no_retrieving_service_configuration ().run ();
+
+    QVERIFY (state_changed.wait (service_state::stopped));
+    // Only the one sent right when serving.
+    QCOMPARE (notify_socket.receive ().count (QByteArrayLiteral ("WATCHDOG=1")), 1);
+    #endif
+}
+
+void test_application::stalled_event_loop_withholds_watchdog_keepalive_by_default ()
+{
+    #if not defined Q_OS_LINUX
+    QSKIP ("The service manager protocol is specific to Linux.");
+    #else
+    notify_socket_test notify_socket;
+    QVERIFY (notify_socket.open ());
+    qputenv ("WATCHDOG_USEC", QByteArrayLiteral ("100000"));
+
+    event_loop_controller_test event_loop;
+    application application;
+    serving_state_changes state_changed (& application);
+
+    connect (& application, & application::start, & application, & application::set_started);
+    connect (& application, & application::stop, & application, & application::set_stopped);
+    connect (
+        & application,
+        & application::state_changed,
+        & application,
+        [& application, & notify_socket] ()
+        {
+            if (not application.state ().serving ())
+                return;
+            // What was sent so far.
+            notify_socket.receive ();
+            // The keepalive due in 50 ms comes out 70 ms late, past half the period.
+            QThread::msleep (120);
+            QTimer::singleShot (std::chrono::milliseconds (20), & application, & application::shut_down);
+        }
+    );
+    application.set_no_retrieving_service_configuration ().run ();
+
+    QVERIFY (state_changed.wait (service_state::stopped));
+    QCOMPARE (application.watchdog_tolerance (), 0.5);
+    QCOMPARE (notify_socket.receive ().count (QByteArrayLiteral ("WATCHDOG=1")), 0);
+    #endif
+}
+
+void test_application::running_as_systemd_service_stores_descriptors ()
+{
+    #if not defined Q_OS_LINUX
+    QSKIP ("The service manager protocol is specific to Linux.");
+    #else
+    notify_socket_test notify_socket;
+    QVERIFY (notify_socket.open ());
+    int pipe [2];
+    QVERIFY (::pipe (pipe) == 0);
+
+    event_loop_controller_test event_loop;
+    application application;
+    serving_state_changes state_changed (& application);
+    bool stored (false);
+
+    QVERIFY (not application.store_descriptor (QStringLiteral ("cache"), pipe [1]));
+    connect (& application, & application::start, & application, & application::set_started);
+    connect (
+        & application,
+        & application::stop,
+        & application,
+        [& application, & stored, & pipe] ()
+        {
+            stored =
+                not application.store_descriptor (QStringLiteral ("invalid:name"), pipe [1])
+                and application.store_descriptor (QStringLiteral ("cache"), pipe [1]);
+            application.set_stopped ();
+        }
+    );
+    connect (
+        & application,
+        & application::state_changed,
+        & application,
+        [& application] ()
+        {
+            if (not application.state ().serving ())
+                return;
+            application.shut_down ();
+        }
+    );
+    application.set_no_retrieving_service_configuration ().run ();
+
+    QVERIFY (state_changed.wait (service_state::stopped));
+    QVERIFY (stored);
+    QVERIFY (notify_socket.receive ().contains (QByteArrayLiteral ("FDSTORE=1\nFDNAME=cache")));
+    QCOMPARE (notify_socket.descriptors.size (), std::size_t (1));
+    // The same pipe comes out on the other end.
+    ::close (pipe [1]);
+    QCOMPARE (::write (notify_socket.descriptors.front (), "x", 1), ssize_t (1));
+    char byte (0);
+    QCOMPARE (::read (pipe [0], & byte, 1), ssize_t (1));
+    QCOMPARE (byte, 'x');
+    ::close (pipe [0]);
+    #endif
+}
+
+void test_application::inheriting_socket_activated_descriptors ()
+{
+    #if not defined Q_OS_LINUX
+    QSKIP ("Inheriting descriptors is only supported on POSIX.");
+    #else
+    // Passed from 3 on in a process of its own, which writes what it inherited.
+    const auto inherit = [] (const char * const case_)
     {
-        if (not changed.value ().wait ())
-            return false;
-    }
-    while (changes.back ().state != value);
-    return true;
+        QProcess process;
+        process.start (QStringLiteral (TEST_APPLICATION_CHILD), { QStringLiteral ("descriptors"), QString::fromUtf8 (case_) });
+        if (not process.waitForFinished () or process.exitStatus () != QProcess::NormalExit or process.exitCode () != 0)
+            return QByteArray ();
+        return process.readAllStandardOutput ();
+    };
+
+    // Taken from the application once listened on. The variables are not passed on to the processes started after.
+    QCOMPARE (inherit ("matching"), QByteArrayLiteral ("listener 3\nenvironment unset\nlistening yes\nleft 0\n"));
+    // Meant for another process, such as the parent that did not unset the variables.
+    QCOMPARE (inherit ("other_process"), QByteArrayLiteral ("environment unset\nlistening no\nleft 0\n"));
+    QCOMPARE (inherit ("no_names"), QByteArrayLiteral ("unknown 3\nenvironment unset\nlistening no\nleft 1\n"));
+    // Fewer names than descriptors.
+    QCOMPARE (
+        inherit ("count_mismatch"),
+        QByteArrayLiteral ("listener 3\nunknown 4\nenvironment unset\nlistening yes\nleft 1\n")
+    );
+    #endif
+}
+
+void test_application::exiting_fast_runs_flushes ()
+{
+    #if not defined Q_OS_LINUX
+    QSKIP ("The process run by the test is only built on Linux.");
+    #else
+    QProcess process;
+    process.start (QStringLiteral (TEST_APPLICATION_CHILD), { QStringLiteral ("fast_exit"), QStringLiteral ("flushing") });
+    QVERIFY (process.waitForFinished ());
+    QCOMPARE (process.exitStatus (), QProcess::NormalExit);
+    QCOMPARE (process.exitCode (), 7);
+    // In the order added, and nothing destroyed after.
+    QCOMPARE (process.readAllStandardOutput (), QByteArrayLiteral ("flush 1\nflush 2\n"));
+    #endif
 }
 
-std::vector<serving_state> serving_state_changes::none_to_stopped ()
+void test_application::exiting_fast_with_hanging_flush_times_out ()
 {
-    return { { service_state::stopped, target_service_state::none } };
+    #if not defined Q_OS_LINUX
+    QSKIP ("The process run by the test is only built on Linux.");
+    #else
+    QProcess process;
+    process.start (QStringLiteral (TEST_APPLICATION_CHILD), { QStringLiteral ("fast_exit"), QStringLiteral ("hanging") });
+    // The timeout is 200 ms.
+    QVERIFY (process.waitForFinished (5000));
+    QCOMPARE (process.exitStatus (), QProcess::NormalExit);
+    QCOMPARE (process.exitCode (), 7);
+    QCOMPARE (process.readAllStandardOutput (), QByteArrayLiteral ("flush 1\nhanging\n"));
+    QVERIFY (process.readAllStandardError ().contains ("Failed to flush in time."));
+    #endif
 }
 
-std::vector<serving_state> serving_state_changes::serving_to_stopped ()
+void test_application::reporting_progress_extends_service_timeout ()
 {
-    return
+    #if not defined Q_OS_LINUX
+    QSKIP ("The service manager protocol is specific to Linux.");
+    #else
+    notify_socket_test notify_socket;
+    QVERIFY (notify_socket.open ());
+
+    event_loop_controller_test event_loop;
+    application application;
+    serving_state_changes state_changed (& application);
+    bool bounded (false);
+
+    connect (
+        & application,
+        & application::start,
+        & application,
+        [& application, & bounded] ()
+        {
+            const auto deadline (application.deadline ());
+            bounded = not deadline.isForever () and deadline.remainingTimeAsDuration () <= std::chrono::seconds (60);
+            application.report_progress ();
+            // Too soon to be passed on.
+            application.report_progress ();
+            application.set_started ();
+        }
+    );
+    connect (& application, & application::stop, & application, & application::set_stopped);
+    connect (
+        & application,
+        & application::state_changed,
+        & application,
+        [& application] ()
+        {
+            if (not application.state ().serving ())
+                return;
+            QVERIFY (application.deadline ().isForever ());
+            application.shut_down ();
+        }
+    );
+    application
+        .set_start_timeout (std::chrono::seconds (60))
+        .set_stop_timeout (std::chrono::seconds (60))
+        .set_no_retrieving_service_configuration ()
+        .run ();
+
+    QVERIFY (state_changed.wait (service_state::stopped));
+    QVERIFY (bounded);
+    QVERIFY (application.deadline ().isForever ());
+    QCOMPARE (
+        notify_socket.receive ().count (QByteArrayLiteral ("EXTEND_TIMEOUT_USEC=5000000")),
+        1
+    );
+    #endif
+}
+
+void test_application::running_as_systemd_service_notifies_reloading ()
+{
+    #if not defined Q_OS_LINUX
+    QSKIP ("The service manager protocol is specific to Linux.");
+    #else
+    notify_socket_test notify_socket;
+    QVERIFY (notify_socket.open ());
+
+    event_loop_controller_test event_loop;
+    application application;
+    serving_state_changes state_changed (& application);
+
+    connect (& application, & application::start, & application, & application::set_started);
+    connect (& application, & application::stop, & application, & application::set_stopped);
+    connect (
+        & application,
+        & application::reload,
+        & application,
+        [& application] ()
+        {
+            application.set_reloaded ();
+            // Stopping right away abandons reloading.
+            QTimer::singleShot (0, & application, & application::shut_down);
+        }
+    );
+    connect (
+        & application,
+        & application::state_changed,
+        & application,
+        [& application] ()
+        {
+            if (not application.state ().serving ())
+                return;
+            ::raise (SIGHUP);
+        }
+    );
+    application.set_no_retrieving_service_configuration ().run ();
+
+    QVERIFY (state_changed.wait (service_state::stopped));
+    const auto messages (notify_socket.receive ());
+    QCOMPARE (messages.size (), 5);
+    QVERIFY (messages.at (1).startsWith (QByteArrayLiteral ("RELOADING=1\nMONOTONIC_USEC=")));
+    QCOMPARE (messages.at (2), QByteArrayLiteral ("READY=1"));
+    QCOMPARE (messages.at (3), QByteArrayLiteral ("STOPPING=1"));
+    #endif
+}
+
+void test_application::receiving_posix_signal_stops_console_application ()
+{
+    #if not defined Q_OS_LINUX
+    QSKIP ("Process signals are specific to POSIX.");
+    #else
+    event_loop_controller_test event_loop;
+    application application;
+    QSignalSpy stop (& application, & application::stop);
+    serving_state_changes state_changed (& application);
+
+    connect (& application, & application::start, & application, & application::set_started);
+    connect (& application, & application::stop, & application, & application::set_stopped);
+    connect (
+        & application,
+        & application::state_changed,
+        & application,
+        [& application] ()
+        {
+            if (not application.state ().serving ())
+                return;
+            // Blocked in this thread, so it stays pending until read from the event loop.
+            ::raise (SIGTERM);
+        }
+    );
+    application.set_no_running_as_service ().run ();
+
+    QVERIFY (state_changed.wait (service_state::stopped));
+    QVERIFY (not stop.isEmpty ());
+    QVERIFY (application.running_as_console_application ().has_value ());
+    QCOMPARE (application.running_as_console_application ().value (), true);
+    QCOMPARE (state_changed.changes, serving_state_changes::serving_to_stopped ());
+    #endif
+}
+
+void test_application::receiving_posix_signals_pauses_and_resumes_console_application ()
+{
+    #if not defined Q_OS_LINUX
+    QSKIP ("Process signals are specific to POSIX.");
+    #else
+    event_loop_controller_test event_loop;
+    application application;
+    QSignalSpy pause_serving (& application, & application::pause_serving);
+    QSignalSpy resume_serving (& application, & application::resume_serving);
+    serving_state_changes state_changed (& application);
+
+    connect (& application, & application::start, & application, & application::set_started);
+    connect (& application, & application::stop, & application, & application::set_stopped);
+    connect (& application, & application::pause_serving, & application, & application::set_paused);
+    connect (& application, & application::resume_serving, & application, & application::set_resumed);
+    connect (
+        & application,
+        & application::state_changed,
+        & application,
+        [& application, & state_changed] ()
+        {
+            if (application.state ().paused ())
+                ::raise (SIGCONT);
+            else if (application.state ().serving () and state_changed.changes.size () == 1)
+                ::raise (SIGTSTP);
+            else if (application.state ().serving ())
+                application.shut_down ();
+        }
+    );
+    application.set_no_running_as_service ().run ();
+
+    QVERIFY (state_changed.wait (service_state::stopped));
+    QCOMPARE (pause_serving.count (), 1);
+    QCOMPARE (resume_serving.count (), 1);
+    QCOMPARE (state_changed.changes.size (), std::size_t (4));
+    #endif
+}
+
+void test_application::upgrading_to_failing_instance_keeps_serving ()
+{
+    #if not defined Q_OS_LINUX
+    QSKIP ("Upgrading is only supported on POSIX.");
+    #else
+    event_loop_controller_test event_loop;
+    console_platform_test console;
+    application application;
+    QSignalSpy upgrade_failed (& application, & application::upgrade_failed);
+    serving_state_changes state_changed (& application);
+
+    // Only while serving.
+    QVERIFY (not application.upgrade (QStringLiteral ("/bin/true"), {}, {}));
+
+    connect (& application, & application::start, & application, & application::set_started);
+    connect (& application, & application::stop, & application, & application::set_stopped);
+    connect (& application, & application::upgrade_failed, & application, & application::shut_down);
+    connect (
+        & application,
+        & application::state_changed,
+        & application,
+        [& application] ()
+        {
+            if (not application.state ().serving ())
+                return;
+            // Exits without telling it is serving.
+            QVERIFY (application.upgrade (QStringLiteral ("/bin/true"), {}, {}, QByteArrayLiteral ("state")));
+        }
+    );
+    application.set_no_running_as_service ().run ();
+
+    QVERIFY (state_changed.wait (service_state::stopped));
+    QCOMPARE (upgrade_failed.count (), 1);
+    QCOMPARE (state_changed.changes, serving_state_changes::serving_to_stopped ());
+    #endif
+}
+
+void test_application::upgrading_passes_descriptors_and_state ()
+{
+    #if not defined Q_OS_LINUX
+    QSKIP ("Upgrading is only supported on POSIX.");
+    #else
+    event_loop_controller_test event_loop;
+    console_platform_test console;
+    application application;
+    QSignalSpy upgrade_failed (& application, & application::upgrade_failed);
+    serving_state_changes state_changed (& application);
+    int pipe [2];
+    QVERIFY (::pipe (pipe) == 0);
+
+    // More descriptors than would fit below a fixed offset, each the write end of the pipe.
+    std::vector<inherited_descriptor> descriptors;
+    QByteArray names;
+    for (int i (0); i < 70; ++i)
     {
-        { service_state::serving, target_service_state::none },
-        { service_state::stopped, target_service_state::none }
+        descriptors.push_back ({ QStringLiteral ("descriptor_%1").arg (i), pipe [1] });
+        names.append ("descriptor_").append (QByteArray::number (i)).append (':');
+    }
+    // The descriptors from 3, then the state at 73 and the end to tell it is serving at 74.
+    // The new instance writes the names and the state to the first descriptor, and tells it is serving.
+    const QStringList arguments {
+        QStringLiteral ("-c"),
+        QStringLiteral (
+            "test \"$LISTEN_PID\" = \"$$\" && test \"$LISTEN_FDS\" = 72 && "
+            "{ echo \"$LISTEN_FDNAMES\"; cat /proc/self/fd/73; } >&3 && printf 1 > /proc/self/fd/74"
+        )
     };
+
+    connect (& application, & application::start, & application, & application::set_started);
+    connect (& application, & application::stop, & application, & application::set_stopped);
+    connect (& application, & application::upgrade_failed, & application, & application::shut_down);
+    connect (
+        & application,
+        & application::state_changed,
+        & application,
+        [& application, & arguments, & descriptors] ()
+        {
+            if (not application.state ().serving ())
+                return;
+            QVERIFY (application.upgrade (QStringLiteral ("/bin/sh"), arguments, descriptors, QByteArrayLiteral ("state")));
+        }
+    );
+    application.set_no_running_as_service ().run ();
+
+    QVERIFY (state_changed.wait (service_state::stopped));
+    QCOMPARE (upgrade_failed.count (), 0);
+    QCOMPARE (state_changed.changes, serving_state_changes::serving_to_stopped ());
+
+    // Read until the new instance exited.
+    ::close (pipe [1]);
+    QByteArray received;
+    char buffer [4096];
+    for (ssize_t size; (size = ::read (pipe [0], buffer, sizeof (buffer))) > 0;)
+        received.append (buffer, static_cast<int> (size));
+    ::close (pipe [0]);
+    QCOMPARE (received, names + "background_upgrade_state:background_upgrade_ready\nstate");
+    #endif
+}
+
+void test_application::destroying_incorrectly_does_not_crash_1 ()
+{
+    #if not defined NDEBUG
+    QSKIP ("Expected to abort.");
+    #endif
+
+    event_loop_controller_test event_loop;
+    service_platform_test service;
+    application * application (new class application);
+
+    application->run ();
+
+    connect (
+        application,
+        & application::start,
+        application,
+        [application] ()
+        {
+            delete application;
+        }
+    );
+}
+
+QStringList logged_messages::messages;
+QtMessageHandler logged_messages::previous (nullptr);
+
+logged_messages::logged_messages ()
+{
+    messages.clear ();
+    previous = qInstallMessageHandler (
+        [] (const QtMsgType type, const QMessageLogContext & context, const QString & message)
+        {
+            messages.append (message);
+            previous (type, context, message);
+        }
+    );
+}
+
+logged_messages::~logged_messages ()
+{
+    qInstallMessageHandler (previous);
+}
+
+void send_system_events_while_serving (
+    application & application, console_platform_test & console, const std::vector<application_system_event> & events
+)
+{
+    QObject::connect (& application, & application::start, & application, & application::set_started);
+    QObject::connect (& application, & application::stop, & application, & application::set_stopped);
+    QObject::connect (& application, & application::pause_serving, & application, & application::set_paused);
+    QObject::connect (& application, & application::resume_serving, & application, & application::set_resumed);
+    QObject::connect (
+        & application,
+        & application::state_changed,
+        & application,
+        [& application, & console, events, sent = false] () mutable
+        {
+            if (sent or not application.state ().serving ())
+                return;
+            sent = true;
+            for (const auto & event : events)
+                Q_EMIT console.event_received (event);
+        }
+    );
+    application.set_no_running_as_service ().run ();
 }
 
-bool signal_utility::connected (const QObject * const object, const QSignalSpy & signal)
+notify_socket_test::notify_socket_test ()
+    : socket (-1)
+{}
+
+notify_socket_test::~notify_socket_test ()
+{
+    #if defined Q_OS_LINUX
+    qunsetenv ("NOTIFY_SOCKET");
+    qunsetenv ("WATCHDOG_USEC");
+    if (socket != -1)
+        ::close (socket);
+    for (const auto descriptor : descriptors)
+        ::close (descriptor);
+    #endif
+}
+
+bool notify_socket_test::open ()
 {
-    return reinterpret_cast<const signal_utility *> (object)->receivers (signal.signal ().prepend ('2')) > 1;
+    #if defined Q_OS_LINUX
+    if (not directory.isValid ())
+        return false;
+    const auto path (QFile::encodeName (directory.filePath (QStringLiteral ("notify"))));
+    sockaddr_un address {};
+    if (static_cast<std::size_t> (path.size ()) >= sizeof (address.sun_path))
+        return false;
+    address.sun_family = AF_UNIX;
+    std::memcpy (address.sun_path, path.constData (), static_cast<std::size_t> (path.size ()));
+    socket = ::socket (AF_UNIX, SOCK_DGRAM bitor SOCK_CLOEXEC bitor SOCK_NONBLOCK, 0);
+    if (socket == -1)
+        return false;
+    if (::bind (socket, reinterpret_cast<const sockaddr *> (& address), sizeof (address)) == -1)
+        return false;
+    qputenv ("NOTIFY_SOCKET", path);
+    return true;
+    #else
+    return false;
+    #endif
+}
+
+QByteArrayList notify_socket_test::receive ()
+{
+    QByteArrayList result;
+    #if defined Q_OS_LINUX
+    char buffer [4096];
+    alignas (cmsghdr) char control [CMSG_SPACE (sizeof (int) * 16)];
+    Q_FOREVER
+    {
+        iovec data { buffer, sizeof (buffer) };
+        msghdr header {};
+        header.msg_iov = & data;
+        header.msg_iovlen = 1;
+        header.msg_control = control;
+        header.msg_controllen = sizeof (control);
+        const auto size (::recvmsg (socket, & header, MSG_CMSG_CLOEXEC));
+        if (size == -1)
+            break;
+        result.append (QByteArray (buffer, static_cast<int> (size)));
+        for (auto * message (CMSG_FIRSTHDR (& header)); message != nullptr; message = CMSG_NXTHDR (& header, message))
+        {
+            if (message->cmsg_level != SOL_SOCKET or message->cmsg_type != SCM_RIGHTS)
+                continue;
+            const auto count ((message->cmsg_len - CMSG_LEN (0)) / sizeof (int));
+            for (std::size_t i (0); i < count; ++i)
+            {
+                int descriptor;
+                std::memcpy (& descriptor, CMSG_DATA (message) + i * sizeof (int), sizeof (int));
+                descriptors.push_back (descriptor);
+            }
+        }
+    }
+    #endif
+    return result;
 }
 
 QTEST_MAIN (test_application)
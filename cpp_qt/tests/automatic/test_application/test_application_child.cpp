@@ -0,0 +1,147 @@
+#include <cstdio>
+#include <cstring>
+#include <optional>
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QThread>
+#include <QtNetwork/QLocalServer>
+
+#include <background/application>
+#include <background/background_network.hpp>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// Run by 'test_application' for what takes a process of its own, such as the descriptors from 3 on.
+// The first argument is what to run, the second the case. The results are written to the standard output.
+
+namespace
+{
+
+// Written once destroyed, which a fast exit skips.
+struct destroyed_report
+{
+    ~destroyed_report ()
+    {
+        std::printf ("destroyed\n");
+    }
+};
+
+bool pass_descriptors (const QByteArray & case_);
+void report_descriptors (background::application & application);
+void add_exit_flushes (background::application & application, const QByteArray & case_);
+
+} // namespace
+
+int main (int argc, char * argv [])
+{
+    if (argc < 3)
+        return 2;
+    const QByteArray mode (argv [1]);
+    const QByteArray case_ (argv [2]);
+    // Before anything else opens a descriptor.
+    if (mode == "descriptors" and not pass_descriptors (case_))
+        return 2;
+
+    std::optional<destroyed_report> report;
+    QCoreApplication application_ (argc, argv);
+    background::application application;
+    if (mode == "fast_exit")
+    {
+        report.emplace ();
+        add_exit_flushes (application, case_);
+    }
+    QObject::connect (& application, & background::application::start, & application, & background::application::set_started);
+    QObject::connect (& application, & background::application::stop, & application, & background::application::set_stopped);
+    QObject::connect (
+        & application, & background::application::state_changed, & application,
+        [& application, & mode] ()
+        {
+            if (not application.state ().serving ())
+                return;
+            if (mode == "descriptors")
+                report_descriptors (application);
+            application.shut_down ();
+        }
+    );
+    application.set_no_running_as_service ().run ();
+
+    return application_.exec ();
+}
+
+namespace
+{
+
+// Listening sockets from 3 on, as passed by the service manager.
+bool pass_descriptors (const QByteArray & case_)
+{
+    const int count (case_ == "count_mismatch" ? 2 : 1);
+    for (int i (0); i < count; ++i)
+    {
+        const auto socket (::socket (AF_UNIX, SOCK_STREAM, 0));
+        if (socket == -1)
+            return false;
+        // Bound to an address of its own in the abstract namespace, with only the family given.
+        sockaddr_un address {};
+        address.sun_family = AF_UNIX;
+        if (
+            ::bind (socket, reinterpret_cast<const sockaddr *> (& address), sizeof (sa_family_t)) == -1
+            or ::listen (socket, 1) == -1
+        )
+            return false;
+        const int target (3 + i);
+        if (socket != target)
+        {
+            if (::dup2 (socket, target) == -1)
+                return false;
+            ::close (socket);
+        }
+    }
+    qputenv ("LISTEN_PID", QByteArray::number (case_ == "other_process" ? ::getppid () : ::getpid ()));
+    qputenv ("LISTEN_FDS", QByteArray::number (count));
+    if (case_ != "no_names")
+        qputenv ("LISTEN_FDNAMES", QByteArrayLiteral ("listener"));
+    return true;
+}
+
+void report_descriptors (background::application & application)
+{
+    for (const auto & descriptor : application.inherited_descriptors ())
+        std::printf ("%s %d\n", qUtf8Printable (descriptor.name), static_cast<int> (descriptor.descriptor));
+    const bool set (
+        qEnvironmentVariableIsSet ("LISTEN_PID")
+        or qEnvironmentVariableIsSet ("LISTEN_FDS")
+        or qEnvironmentVariableIsSet ("LISTEN_FDNAMES")
+    );
+    std::printf ("environment %s\n", set ? "set" : "unset");
+    QLocalServer server;
+    const bool listening (background::listen_inherited (application, QStringLiteral ("listener"), server));
+    std::printf ("listening %s\n", listening ? "yes" : "no");
+    std::printf ("left %d\n", static_cast<int> (application.inherited_descriptors ().size ()));
+}
+
+// Flushed right away, as the guard ends the process without flushing the standard output.
+void add_exit_flushes (background::application & application, const QByteArray & case_)
+{
+    application.set_exit_code (7);
+    application
+    .set_with_fast_exit ()
+    .set_fast_exit_timeout (std::chrono::milliseconds (200));
+    application.add_exit_flush ([] () { std::printf ("flush 1\n"); std::fflush (stdout); });
+    if (case_ == "hanging")
+    {
+        application.add_exit_flush (
+            [] ()
+            {
+                std::printf ("hanging\n");
+                std::fflush (stdout);
+                Q_FOREVER
+                    QThread::sleep (1);
+            }
+        );
+    }
+    application.add_exit_flush ([] () { std::printf ("flush 2\n"); std::fflush (stdout); });
+}
+
+} // namespace
@@ -0,0 +1,181 @@
+#include <vector>
+#include <cstdint>
+
+#include <QtTest/QTest>
+#include <QtCore/QTemporaryDir>
+#include <QtCore/QFile>
+#include <QtCore/QThread>
+
+#include <background/log_writer>
+
+using namespace background;
+
+class test_log_writer : public QObject
+{
+    private Q_SLOTS:
+    void writing_log_lines_from_threads ();
+    void writing_log_lines_to_full_ring_reports_dropped ();
+    void writing_log_lines_to_full_ring_blocks ();
+    void rotating_log_by_size_keeps_generations ();
+    void installing_message_handler_keeps_installed_writer ();
+
+    private:
+    Q_OBJECT
+};
+
+void test_log_writer::writing_log_lines_from_threads ()
+{
+    QTemporaryDir directory;
+    QVERIFY (directory.isValid ());
+    const auto path (directory.filePath (QStringLiteral ("log.txt")));
+    log_writer writer;
+    // Waits in the ring until open.
+    QVERIFY (writer.write (QByteArrayLiteral ("first")));
+    QVERIFY (writer.open (path));
+
+    std::vector<QThread *> threads;
+    for (int i (0); i < 4; ++i)
+    {
+        threads.push_back (QThread::create (
+            [& writer, i] ()
+            {
+                for (int j (0); j < 1000; ++j)
+                    writer.write (QByteArray::number (i) + ' ' + QByteArray::number (j));
+            }
+        ));
+        threads.back ()->start ();
+    }
+    for (auto * const thread : threads)
+    {
+        QVERIFY (thread->wait ());
+        delete thread;
+    }
+    writer.flush ();
+    writer.close ();
+
+    QFile file (path);
+    QVERIFY (file.open (QIODevice::ReadOnly));
+    const auto lines (file.readAll ().split ('\n'));
+    // Each line followed by a break, the last split empty.
+    QCOMPARE (writer.dropped (), std::uint64_t (0));
+    QCOMPARE (lines.size (), 4002);
+    QCOMPARE (lines.front (), QByteArrayLiteral ("first"));
+    QVERIFY (lines.back ().isEmpty ());
+}
+
+void test_log_writer::writing_log_lines_to_full_ring_reports_dropped ()
+{
+    QTemporaryDir directory;
+    QVERIFY (directory.isValid ());
+    const auto path (directory.filePath (QStringLiteral ("log.txt")));
+    log_writer writer (4, log_writer::overflow_policy::drop_and_report);
+    for (int i (0); i < 6; ++i)
+        writer.write (QByteArray::number (i));
+    QCOMPARE (writer.dropped (), std::uint64_t (2));
+    QVERIFY (writer.open (path));
+    writer.flush ();
+    writer.close ();
+
+    QFile file (path);
+    QVERIFY (file.open (QIODevice::ReadOnly));
+    QCOMPARE (file.readAll (), QByteArrayLiteral ("0\n1\n2\n3\nDropped log lines: 2.\n"));
+}
+
+void test_log_writer::writing_log_lines_to_full_ring_blocks ()
+{
+    QTemporaryDir directory;
+    QVERIFY (directory.isValid ());
+    const auto path (directory.filePath (QStringLiteral ("log.txt")));
+    // Far fewer slots than lines, so that the threads wait on the writer most of the time.
+    log_writer writer (4, log_writer::overflow_policy::block);
+    QVERIFY (writer.open (path));
+
+    std::vector<QThread *> threads;
+    for (int i (0); i < 4; ++i)
+    {
+        threads.push_back (QThread::create (
+            [& writer] ()
+            {
+                for (int j (0); j < 1000; ++j)
+                    writer.write (QByteArray::number (j));
+            }
+        ));
+        threads.back ()->start ();
+    }
+    for (auto * const thread : threads)
+    {
+        QVERIFY (thread->wait ());
+        delete thread;
+    }
+    writer.flush ();
+    writer.close ();
+
+    QCOMPARE (writer.dropped (), std::uint64_t (0));
+    QFile file (path);
+    QVERIFY (file.open (QIODevice::ReadOnly));
+    QCOMPARE (file.readAll ().count ('\n'), 4000);
+}
+
+void test_log_writer::rotating_log_by_size_keeps_generations ()
+{
+    QTemporaryDir directory;
+    QVERIFY (directory.isValid ());
+    const auto path = [& directory] (const char * const name) { return directory.filePath (QString::fromUtf8 (name)); };
+    const auto contents = [] (const QString & path_)
+    {
+        QFile file (path_);
+        return file.open (QIODevice::ReadOnly) ? file.readAll () : QByteArray ();
+    };
+    log_writer writer;
+    writer.set_rotation_size (6).set_rotation_generations (2);
+    QVERIFY (writer.open (path ("log.txt")));
+    // A line each file, rotated once it is written.
+    for (const auto * const line : { "line 1", "line 2", "line 3" })
+    {
+        writer.write (QByteArray (line));
+        writer.flush ();
+    }
+    writer.write (QByteArrayLiteral ("4"));
+    writer.close ();
+
+    QCOMPARE (contents (path ("log.txt")), QByteArrayLiteral ("4\n"));
+    QCOMPARE (contents (path ("log.1.txt")), QByteArrayLiteral ("line 3\n"));
+    QCOMPARE (contents (path ("log.2.txt")), QByteArrayLiteral ("line 2\n"));
+    QVERIFY (not QFile::exists (path ("log.3.txt")));
+}
+
+void test_log_writer::installing_message_handler_keeps_installed_writer ()
+{
+    QTemporaryDir directory;
+    QVERIFY (directory.isValid ());
+    const auto path = [& directory] (const char * const name) { return directory.filePath (QString::fromUtf8 (name)); };
+    const auto contents = [] (const QString & path_)
+    {
+        QFile file (path_);
+        return file.open (QIODevice::ReadOnly) ? file.readAll () : QByteArray ();
+    };
+    log_writer installed;
+    log_writer other;
+    QVERIFY (installed.open (path ("installed.txt")));
+    QVERIFY (other.open (path ("other.txt")));
+    installed.install_message_handler ();
+    other.install_message_handler ();
+    qInfo ("message 1");
+    // Not installed, so not uninstalling the other one.
+    other.uninstall_message_handler ();
+    qInfo ("message 2");
+    installed.uninstall_message_handler ();
+    qInfo ("message 3");
+    installed.close ();
+    other.close ();
+
+    const auto lines (contents (path ("installed.txt")));
+    QVERIFY (lines.contains ("message 1"));
+    QVERIFY (lines.contains ("message 2"));
+    QVERIFY (not lines.contains ("message 3"));
+    QVERIFY (contents (path ("other.txt")).isEmpty ());
+}
+
+QTEST_MAIN (test_log_writer)
+
+#include "test_log_writer.moc"
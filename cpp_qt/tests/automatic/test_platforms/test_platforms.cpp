@@ -0,0 +1,305 @@
+#if not defined QT_STATICPLUGIN
+#define QT_STATICPLUGIN
+#endif
+#include "test_platforms.hpp"
+
+#include <QtCore/QPluginLoader>
+
+template <class T> T * plugin ()
+{
+    const auto plugins (QPluginLoader::staticPlugins ());
+    for (const auto & plugin : plugins)
+    {
+        if (plugin.instance ()->metaObject () != & T::staticMetaObject)
+            continue;
+        return reinterpret_cast <T *> (plugin.instance ());
+    }
+    return nullptr;
+}
+
+class event_loop_controller_plugin_test : public event_loop_controller_plugin
+{
+    public :
+    event_loop_controller_plugin_test (QObject * parent = nullptr);
+
+    public :
+    event_loop_controller * create (QObject * parent) override;
+
+    private :
+    event_loop_controller * controller = nullptr;
+    friend class event_loop_controller_test;
+
+    private :
+    Q_OBJECT
+    Q_PLUGIN_METADATA (IID "background.event_loop_controller_plugin")
+    Q_INTERFACES (background::event_loop_controller_plugin)
+};
+
+Q_IMPORT_PLUGIN (event_loop_controller_plugin_test)
+
+event_loop_controller_plugin_test::event_loop_controller_plugin_test (QObject * const parent)
+    : event_loop_controller_plugin (parent)
+{}
+
+event_loop_controller * event_loop_controller_plugin_test::create (QObject * const parent)
+{
+    Q_UNUSED (parent)
+    return controller;
+}
+
+event_loop_controller_test::event_loop_controller_test ()
+    : event_loop_controller (nullptr),
+    exited (this, & event_loop_controller_test::exit_)
+{
+    plugin<event_loop_controller_plugin_test> ()->controller = this;
+}
+
+event_loop_controller_test::~event_loop_controller_test ()
+{
+    plugin<event_loop_controller_plugin_test> ()->controller = nullptr;
+}
+
+void event_loop_controller_test::exit (const int exit_code)
+{
+    Q_EMIT exit_ (exit_code);
+}
+
+class service_platform_plugin_test : public service_platform_plugin
+{
+    public :
+    service_platform_plugin_test (QObject * parent = nullptr);
+
+    public :
+    unsigned int order () const override;
+    bool detect () override;
+    service_platform * create (QObject * parent) override;
+
+    private :
+    service_platform * service = nullptr;
+    friend class service_platform_test;
+
+    private :
+    Q_OBJECT
+    Q_PLUGIN_METADATA (IID "background.service_platform_plugin")
+    Q_INTERFACES (background::service_platform_plugin)
+};
+
+Q_IMPORT_PLUGIN (service_platform_plugin_test)
+
+service_platform_plugin_test::service_platform_plugin_test (QObject * const parent)
+    : service_platform_plugin (parent)
+{}
+
+unsigned int service_platform_plugin_test::order () const
+{
+    return 1;
+}
+
+bool service_platform_plugin_test::detect ()
+{
+    return service != nullptr;
+}
+
+service_platform * service_platform_plugin_test::create (QObject * const parent)
+{
+    Q_UNUSED (parent)
+    return service;
+}
+
+service_platform_test::service_platform_test ()
+    : service_platform (nullptr),
+    checked (this, & service_platform_test::check_),
+    started_ (this, & service_platform_test::start_),
+    stopped_ (this, & service_platform_test::stop_),
+    state_serving_set_ (this, & service_platform_test::set_state_serving_),
+    state_stopping_set_ (this, & service_platform_test::set_state_stopping_),
+    state_stopped_set_ (this, & service_platform_test::set_state_stopped_),
+    configuration_retrieved_ (this, & service_platform_test::retrieve_configuration_)
+{
+    plugin<service_platform_plugin_test> ()->service = this;
+}
+
+service_platform_test::~service_platform_test ()
+{
+    plugin<service_platform_plugin_test> ()->service = nullptr;
+}
+
+bool service_platform_test::check ()
+{
+    const bool result (Q_EMIT check_ ());
+    if (not signal_utility::connected (this, checked))
+        return true;
+    return result;
+}
+
+void service_platform_test::start ()
+{
+    Q_EMIT start_ ();
+    if (not signal_utility::connected (this, started_))
+        Q_EMIT started ();
+}
+
+void service_platform_test::stop ()
+{
+    Q_EMIT stop_ ();
+    if (not signal_utility::connected (this, stopped_))
+        Q_EMIT stopped ();
+}
+
+void service_platform_test::set_state_serving ()
+{
+    Q_EMIT set_state_serving_ ();
+    if (not signal_utility::connected (this, state_serving_set_))
+        Q_EMIT state_serving_set ();
+}
+
+void service_platform_test::set_state_stopping ()
+{
+    Q_EMIT set_state_stopping_ ();
+    if (not signal_utility::connected (this, state_stopping_set_))
+        Q_EMIT state_stopping_set ();
+}
+
+void service_platform_test::set_state_stopped (const int exit_code)
+{
+    Q_EMIT set_state_stopped_ (exit_code);
+    if (not signal_utility::connected (this, state_stopped_set_))
+        Q_EMIT state_stopped_set ();
+}
+
+void service_platform_test::retrieve_configuration ()
+{
+    Q_EMIT retrieve_configuration_ ();
+    if (not signal_utility::connected (this, configuration_retrieved_))
+        Q_EMIT configuration_retrieved (
+            service_configuration
+            {
+                QStringLiteral ("test_service"),
+                QStringLiteral ("Test Service."),
+                QStringLiteral ("test_service"),
+                QStringLiteral ("test"),
+            }
+        );
+}
+
+void service_platform_test::send_stop ()
+{
+    Q_EMIT event_received (application_system_event { application_system_event::stop, QStringLiteral ("test") });
+}
+
+class console_platform_plugin_test : public console_platform_plugin
+{
+    public :
+    console_platform_plugin_test (QObject * parent = nullptr);
+
+    public :
+    unsigned int order () const override;
+    console_platform * create (QObject * parent) override;
+
+    private :
+    console_platform * console = nullptr;
+    friend class console_platform_test;
+
+    private :
+    Q_OBJECT
+    Q_PLUGIN_METADATA (IID "background.console_platform_plugin")
+    Q_INTERFACES (background::console_platform_plugin)
+};
+
+Q_IMPORT_PLUGIN (console_platform_plugin_test)
+
+console_platform_plugin_test::console_platform_plugin_test (QObject * const parent)
+    : console_platform_plugin (parent)
+{}
+
+unsigned int console_platform_plugin_test::order () const
+{
+    return 1;
+}
+
+console_platform * console_platform_plugin_test::create (QObject * const parent)
+{
+    Q_UNUSED (parent)
+    return console;
+}
+
+console_platform_test::console_platform_test ()
+    : console_platform (nullptr),
+    started_ (this, & console_platform_test::start_),
+    stopped_ (this, & console_platform_test::stop_)
+{
+    plugin<console_platform_plugin_test> ()->console = this;
+}
+
+console_platform_test::~console_platform_test ()
+{
+    plugin<console_platform_plugin_test> ()->console = nullptr;
+}
+
+void console_platform_test::start ()
+{
+    Q_EMIT start_ ();
+    if (not signal_utility::connected (this, started_))
+        Q_EMIT started ();
+}
+
+void console_platform_test::stop ()
+{
+    Q_EMIT stop_ ();
+    if (not signal_utility::connected (this, stopped_))
+        Q_EMIT stopped ();
+}
+
+void console_platform_test::send_stop ()
+{
+    Q_EMIT event_received (application_system_event { application_system_event::stop, QStringLiteral ("test") });
+}
+
+serving_state_changes::serving_state_changes (application * const application)
+    : changed (std::nullopt),
+    application_ (application)
+{
+    QObject::connect (
+        application,
+        & application::state_changed,
+        application,
+        [this, application] ()
+        {
+            changes.push_back (application->state ());
+        }
+    );
+}
+
+bool serving_state_changes::wait (service_state value)
+{
+    if (not changed.has_value ())
+        changed.emplace (application_, & application::state_changed);
+    do
+    {
+        if (not changed.value ().wait ())
+            return false;
+    }
+    while (changes.back ().state != value);
+    return true;
+}
+
+std::vector<serving_state> serving_state_changes::none_to_stopped ()
+{
+    return { { service_state::stopped, target_service_state::none } };
+}
+
+std::vector<serving_state> serving_state_changes::serving_to_stopped ()
+{
+    return
+    {
+        { service_state::serving, target_service_state::none },
+        { service_state::stopped, target_service_state::none }
+    };
+}
+
+bool signal_utility::connected (const QObject * const object, const QSignalSpy & signal)
+{
+    return reinterpret_cast<const signal_utility *> (object)->receivers (signal.signal ().prepend ('2')) > 1;
+}
+
+#include "test_platforms.moc"
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <vector>
+#include <optional>
+
+#include <QtTest/QSignalSpy>
+
+#include <background/application>
+#include <background/background_event_loop_controller.hpp>
+#include <background/background_service_platform.hpp>
+#include <background/background_console_platform.hpp>
+
+// Stand-ins for the platforms, injected as static plugins while they exist.
+// Shared by the tests and the benchmarks.
+
+using namespace background;
+
+class event_loop_controller_test : public event_loop_controller
+{
+    public :
+    event_loop_controller_test ();
+    ~event_loop_controller_test ();
+
+    QSignalSpy exited;
+
+    public Q_SLOTS :
+    void exit (int exit_code) override;
+
+    Q_SIGNALS :
+    void exit_ (int exit_code);
+
+    private :
+    Q_OBJECT
+};
+
+class service_platform_test : public service_platform
+{
+    public :
+    service_platform_test ();
+    ~service_platform_test ();
+
+    QSignalSpy checked;
+
+    QSignalSpy started_;
+    QSignalSpy stopped_;
+
+    QSignalSpy state_serving_set_;
+    QSignalSpy state_stopping_set_;
+    QSignalSpy state_stopped_set_;
+
+    QSignalSpy configuration_retrieved_;
+
+    public Q_SLOTS :
+    bool check () override;
+
+    void start () override;
+    void stop () override;
+
+    void set_state_serving () override;
+    void set_state_stopping () override;
+    void set_state_stopped (int exit_code) override;
+
+    void retrieve_configuration () override;
+
+    Q_SIGNALS :
+    bool check_ ();
+
+    void start_ ();
+    void stop_ ();
+
+    void set_state_serving_ ();
+    void set_state_stopping_ ();
+    void set_state_stopped_ (int exit_code);
+
+    void retrieve_configuration_ ();
+
+    public Q_SLOTS :
+    void send_stop ();
+
+    private :
+    Q_OBJECT
+};
+
+class console_platform_test : public console_platform
+{
+    public :
+    console_platform_test ();
+    ~console_platform_test ();
+
+    QSignalSpy started_;
+    QSignalSpy stopped_;
+
+    public Q_SLOTS :
+    void start () override;
+    void stop () override;
+
+    Q_SIGNALS :
+    void start_ ();
+    void stop_ ();
+
+    public Q_SLOTS :
+    void send_stop ();
+
+    private :
+    Q_OBJECT
+};
+
+struct serving_state_changes
+{
+    serving_state_changes (application * application);
+
+    bool wait (service_state value);
+
+    application * const application_;
+    std::vector<serving_state> changes;
+    std::optional<QSignalSpy> changed;
+
+    static std::vector<serving_state> none_to_stopped ();
+    static std::vector<serving_state> serving_to_stopped ();
+    static std::vector<serving_state> serving_stopping_to_stopped ();
+};
+
+struct signal_utility : QObject
+{
+    static bool connected (const QObject * object, const QSignalSpy & signal);
+};
@@ -0,0 +1,196 @@
+#include <stdexcept>
+
+#include <QtTest/QTest>
+#include <QtTest/QSignalSpy>
+#include <QtCore/QTimer>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QPromise>
+
+#include <background/application>
+#include <background/background_task.hpp>
+
+#include "test_platforms.hpp"
+
+using namespace background;
+
+class test_task : public QObject
+{
+    private Q_SLOTS:
+    void returning_true_sets_started ();
+    void returning_false_sets_failed_to_start ();
+    void throwing_sets_failed_to_start ();
+    void stopping_cancels_starting ();
+    void awaiting_all_runs_at_the_same_time ();
+
+    private:
+    Q_OBJECT
+};
+
+namespace
+{
+
+// Records where it is destroyed, as a local of a coroutine.
+struct destroyed_flag
+{
+    ~destroyed_flag ()
+    {
+        destroyed = true;
+    }
+
+    bool & destroyed;
+};
+
+task<bool> probe (const std::chrono::milliseconds interval, const bool result)
+{
+    co_await delay (interval);
+    co_return result;
+}
+
+} // namespace
+
+void test_task::returning_true_sets_started ()
+{
+    event_loop_controller_test event_loop;
+    console_platform_test console;
+    application application;
+    serving_state_changes state_changed (& application);
+    QTimer timer;
+    timer.setSingleShot (true);
+    bool stopped (false);
+
+    coroutine_handlers handlers (application);
+    handlers
+    .set_start (
+        [& timer] () -> task<bool>
+        {
+            co_await delay (std::chrono::milliseconds (10));
+            timer.start (std::chrono::milliseconds (10));
+            co_await next_signal (& timer, & QTimer::timeout);
+            QPromise<int> promise;
+            promise.start ();
+            auto future_ (promise.future ());
+            QTimer::singleShot (std::chrono::milliseconds (10), & timer, [& promise] () { promise.addResult (1); promise.finish (); });
+            co_return co_await future (future_) == 1;
+        }
+    )
+    .set_stop (
+        [& stopped] () -> task<>
+        {
+            co_await delay (std::chrono::milliseconds (10));
+            stopped = true;
+        }
+    );
+    application.set_no_running_as_service ().run ();
+
+    QVERIFY (state_changed.wait (service_state::serving));
+    application.shut_down ();
+    QVERIFY (state_changed.wait (service_state::stopped));
+    QVERIFY (stopped);
+}
+
+void test_task::returning_false_sets_failed_to_start ()
+{
+    event_loop_controller_test event_loop;
+    console_platform_test console;
+    application application;
+    serving_state_changes state_changed (& application);
+
+    coroutine_handlers handlers (application);
+    handlers.set_start ([] () { return probe (std::chrono::milliseconds (10), false); });
+    application.set_no_running_as_service ().run ();
+
+    QVERIFY (state_changed.wait (service_state::stopped));
+    QCOMPARE (state_changed.changes, serving_state_changes::none_to_stopped ());
+}
+
+void test_task::throwing_sets_failed_to_start ()
+{
+    event_loop_controller_test event_loop;
+    console_platform_test console;
+    application application;
+    serving_state_changes state_changed (& application);
+
+    coroutine_handlers handlers (application);
+    handlers.set_start (
+        [] () -> task<bool>
+        {
+            co_await delay (std::chrono::milliseconds (10));
+            throw std::runtime_error ("test");
+        }
+    );
+    application.set_no_running_as_service ().run ();
+
+    QVERIFY (state_changed.wait (service_state::stopped));
+    QCOMPARE (state_changed.changes, serving_state_changes::none_to_stopped ());
+}
+
+void test_task::stopping_cancels_starting ()
+{
+    event_loop_controller_test event_loop;
+    console_platform_test console;
+    application application;
+    serving_state_changes state_changed (& application);
+    QSignalSpy start (& application, & application::start);
+    QTimer timer;
+    timer.setSingleShot (true);
+    bool resumed (false);
+    bool destroyed (false);
+
+    coroutine_handlers handlers (application);
+    handlers.set_start (
+        [& timer, & resumed, & destroyed] () -> task<bool>
+        {
+            const destroyed_flag flag { destroyed };
+            co_await next_signal (& timer, & QTimer::timeout);
+            resumed = true;
+            co_return true;
+        }
+    );
+    application.set_with_stop_starting ().set_no_running_as_service ().run ();
+
+    QVERIFY (start.wait ());
+    QVERIFY (not destroyed);
+    application.shut_down ();
+    QVERIFY (state_changed.wait (service_state::stopped));
+    QCOMPARE (state_changed.changes, serving_state_changes::none_to_stopped ());
+    QVERIFY (destroyed);
+    timer.start (std::chrono::milliseconds (1));
+    QTest::qWait (20);
+    QVERIFY (not resumed);
+}
+
+void test_task::awaiting_all_runs_at_the_same_time ()
+{
+    event_loop_controller_test event_loop;
+    console_platform_test console;
+    application application;
+    serving_state_changes state_changed (& application);
+    std::vector<bool> results;
+
+    coroutine_handlers handlers (application);
+    handlers.set_start (
+        [& results] () -> task<bool>
+        {
+            std::vector<task<bool>> probes;
+            probes.push_back (probe (std::chrono::milliseconds (200), true));
+            probes.push_back (probe (std::chrono::milliseconds (200), false));
+            probes.push_back (probe (std::chrono::milliseconds (200), true));
+            results = co_await when_all (std::move (probes));
+            co_return true;
+        }
+    );
+    QElapsedTimer elapsed;
+    elapsed.start ();
+    application.set_no_running_as_service ().run ();
+
+    QVERIFY (state_changed.wait (service_state::serving));
+    // Waiting one after another would take 600 ms.
+    QVERIFY (elapsed.elapsed () < 500);
+    QCOMPARE (results, std::vector<bool> ({ true, false, true }));
+    application.shut_down ();
+    QVERIFY (state_changed.wait (service_state::stopped));
+}
+
+QTEST_MAIN (test_task)
+
+#include "test_task.moc"